@@ -60,6 +60,13 @@ struct zmk_behavior_ref {
     const struct device *device;
 };
 
+/**
+ * One slot per behavior, filled at boot with the behaviors that have local IDs, in ID order.
+ */
+struct zmk_behavior_local_id_slot {
+    const struct device *device;
+};
+
 /**
  * Registers @p node_id as a behavior.
  */
@@ -67,7 +74,10 @@ struct zmk_behavior_ref {
     static const STRUCT_SECTION_ITERABLE(zmk_behavior_ref,                                         \
                                          _CONCAT(zmk_behavior_, DEVICE_DT_NAME_GET(node_id))) = {  \
         .device = DEVICE_DT_GET(node_id),                                                          \
-    }
+    };                                                                                             \
+    static STRUCT_SECTION_ITERABLE(zmk_behavior_local_id_slot,                                     \
+                                   _CONCAT(zmk_behavior_local_id_slot_,                            \
+                                           DEVICE_DT_NAME_GET(node_id)))
 
 /**
  * @brief Like DEVICE_DT_DEFINE(), but also registers the device as a behavior.
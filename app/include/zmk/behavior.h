@@ -36,3 +36,30 @@ struct zmk_behavior_binding_event {
  * unrelated node which shares the same name as a behavior.
  */
 const struct device *zmk_behavior_get_binding(const char *name);
+
+/**
+ * @brief Get the local ID of the behavior with the given @p name.
+ *
+ * Local IDs are only assigned to behaviors which are not central-local, i.e. the ones a split
+ * central may invoke on a peripheral. They are only meaningful to another device if
+ * zmk_behavior_get_table_hash() matches on both.
+ *
+ * @retval The non-negative local ID of the behavior.
+ * @retval -ENODEV if no behavior has the given name, or it is central-local.
+ */
+int zmk_behavior_get_local_id(const char *name);
+
+/**
+ * @brief Get a const struct device* for a behavior from its local ID.
+ *
+ * @retval Pointer to the device structure for the behavior with the given local ID.
+ * @retval NULL if the ID is out of range or the behavior's initialization function failed.
+ */
+const struct device *zmk_behavior_get_binding_by_local_id(uint16_t id);
+
+/**
+ * @brief Get a hash of the names of all behaviors which have a local ID.
+ *
+ * Two firmwares with the same hash assign the same local ID to each behavior.
+ */
+uint32_t zmk_behavior_get_table_hash(void);
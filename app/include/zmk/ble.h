@@ -6,12 +6,14 @@
 
 #pragma once
 
+#include <zephyr/bluetooth/conn.h>
+
 #include <zmk/keys.h>
 #include <zmk/ble/profile.h>
 
 #define ZMK_BLE_IS_CENTRAL                                                                         \
     (IS_ENABLED(CONFIG_ZMK_SPLIT) && IS_ENABLED(CONFIG_ZMK_BLE) &&                                 \
-     IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL))
+     IS_ENABLED(CONFIG_ZMK_SPLIT_BLE) && IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL))
 
 #if ZMK_BLE_IS_CENTRAL
 #define ZMK_BLE_PROFILE_COUNT (CONFIG_BT_MAX_PAIRED - CONFIG_ZMK_SPLIT_BLE_CENTRAL_PERIPHERALS)
@@ -36,6 +38,13 @@ char *zmk_ble_active_profile_name(void);
 
 int zmk_ble_unpair_all(void);
 
+/**
+ * Requests the LE 2M PHY and/or data length extension on the given connection, as enabled by
+ * CONFIG_ZMK_BLE_PREFER_2M_PHY and CONFIG_ZMK_BLE_DATA_LENGTH_EXTENSION. The link stays on its
+ * current PHY and data length if the peer rejects the request.
+ */
+void zmk_ble_request_link_upgrade(struct bt_conn *conn);
+
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
 int zmk_ble_put_peripheral_addr(const bt_addr_le_t *addr);
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL) */
@@ -9,9 +9,24 @@
 #include <zmk/keys.h>
 #include <zmk/hid.h>
 
+struct zmk_hog_queue_stats {
+    /** Number of reports currently waiting to be notified. */
+    uint32_t depth;
+    /** Highest number of reports that have been waiting at once. */
+    uint32_t max_depth;
+    /** Reports folded into a queued report without hiding any transition. */
+    uint32_t merged;
+    /** Reports forcibly folded into a queued report because the queue stayed full. */
+    uint32_t dropped;
+};
+
 int zmk_hog_send_keyboard_report(struct zmk_hid_keyboard_report_body *body);
 int zmk_hog_send_consumer_report(struct zmk_hid_consumer_report_body *body);
 
+void zmk_hog_get_keyboard_queue_stats(struct zmk_hog_queue_stats *stats);
+void zmk_hog_get_consumer_queue_stats(struct zmk_hog_queue_stats *stats);
+
 #if IS_ENABLED(CONFIG_ZMK_MOUSE)
 int zmk_hog_send_mouse_report(struct zmk_hid_mouse_report_body *body);
+void zmk_hog_get_mouse_queue_stats(struct zmk_hog_queue_stats *stats);
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
@@ -9,3 +9,14 @@
 #include <zephyr/device.h>
 
 int zmk_kscan_init(const struct device *dev);
+
+struct zmk_kscan_event_queue_stats {
+    // Number of times the KSCAN event queue overflowed and had to be resynced.
+    uint32_t overflows;
+    // Number of completed resyncs.
+    uint32_t resyncs;
+    // Highest number of events seen waiting in the queue.
+    uint32_t max_depth;
+};
+
+int zmk_kscan_get_event_queue_stats(struct zmk_kscan_event_queue_stats *stats);
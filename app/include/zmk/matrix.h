@@ -26,6 +26,9 @@
 #elif DT_NODE_HAS_PROP(ZMK_MATRIX_NODE_ID, input_gpios)
 #define ZMK_MATRIX_ROWS 1
 #define ZMK_MATRIX_COLS DT_PROP_LEN(ZMK_MATRIX_NODE_ID, input_gpios)
+#elif DT_NODE_HAS_COMPAT(ZMK_MATRIX_NODE_ID, zmk_kscan_74hc165)
+#define ZMK_MATRIX_ROWS DT_PROP_LEN_OR(ZMK_MATRIX_NODE_ID, output_gpios, 1)
+#define ZMK_MATRIX_COLS DT_PROP(ZMK_MATRIX_NODE_ID, inputs)
 #else
 #define ZMK_MATRIX_ROWS DT_PROP(ZMK_MATRIX_NODE_ID, rows)
 #define ZMK_MATRIX_COLS DT_PROP(ZMK_MATRIX_NODE_ID, columns)
@@ -4,18 +4,17 @@
 #include <zephyr/bluetooth/addr.h>
 #include <zmk/behavior.h>
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
-#include <zmk/hid_indicators_types.h>
-#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
-
-int zmk_split_bt_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
-                                 struct zmk_behavior_binding_event event, bool state);
-
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
-
-int zmk_split_bt_update_hid_indicator(zmk_hid_indicators_t indicators);
-
-#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+struct zmk_split_central_position_queue_stats {
+    // Number of times a peripheral's event queue overflowed and had to be resynced.
+    uint32_t overflows;
+    // Number of completed resyncs, including those releasing keys of a disconnected peripheral.
+    uint32_t resyncs;
+    // Highest number of events seen waiting in the queue.
+    size_t max_depth;
+};
+
+int zmk_split_bt_central_get_position_queue_stats(
+    uint8_t source, struct zmk_split_central_position_queue_stats *stats);
 
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
 
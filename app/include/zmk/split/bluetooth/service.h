@@ -6,11 +6,17 @@
 
 #pragma once
 
+#include <zephyr/sys/util.h>
+
 #include <zmk/events/sensor_event.h>
+#include <zmk/matrix.h>
 #include <zmk/sensors.h>
 
 #define ZMK_SPLIT_RUN_BEHAVIOR_DEV_LEN 9
 
+// Size of the position state bitmap, one bit per key position.
+#define ZMK_SPLIT_POS_STATE_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+
 struct sensor_event {
     uint8_t sensor_index;
 
@@ -18,6 +24,40 @@ struct sensor_event {
     struct zmk_sensor_channel_data channel_data[ZMK_SENSOR_EVENT_MAX_CHANNELS];
 } __packed;
 
+/*
+ * Net change of one sensor channel since the previous notification. Notifications of the sensor
+ * deltas characteristic hold one of these per changed sensor channel.
+ */
+struct zmk_split_sensor_delta {
+    uint8_t sensor_index;
+    // All remaining fields are little endian.
+    uint16_t channel;
+    int32_t val1;
+    int32_t val2;
+} __packed;
+
+#define ZMK_SPLIT_POSITION_EVENT_PRESSED BIT(15)
+#define ZMK_SPLIT_POSITION_EVENT_AGE_MAX (ZMK_SPLIT_POSITION_EVENT_PRESSED - 1)
+
+struct zmk_split_position_event {
+    // Little endian.
+    uint16_t position;
+    // Little endian. ZMK_SPLIT_POSITION_EVENT_PRESSED is set for presses, the remaining bits hold
+    // how many milliseconds before the notification timestamp the key was scanned.
+    uint16_t state_age;
+} __packed;
+
+struct zmk_split_position_events {
+    // Sequence number of the first event. Every event sent or dropped by the peripheral takes up
+    // one sequence number, so the central can detect lost events and resync from the position
+    // state bitmap.
+    uint8_t sequence;
+    // Little endian, lower 32 bits of the peripheral's uptime in milliseconds when sent. Lets the
+    // central estimate the offset between the two clocks and map scan times into its own.
+    uint32_t timestamp;
+    struct zmk_split_position_event events[];
+} __packed;
+
 struct zmk_split_run_behavior_data {
     uint8_t position;
     uint8_t state;
@@ -30,8 +70,16 @@ struct zmk_split_run_behavior_payload {
     char behavior_dev[ZMK_SPLIT_RUN_BEHAVIOR_DEV_LEN];
 } __packed;
 
-int zmk_split_bt_position_pressed(uint8_t position);
-int zmk_split_bt_position_released(uint8_t position);
-int zmk_split_bt_sensor_triggered(uint8_t sensor_index,
-                                  const struct zmk_sensor_channel_data channel_data[],
-                                  size_t channel_data_size);
+/*
+ * Compact alternative to zmk_split_run_behavior_payload, used once the central has read the
+ * peripheral's behavior table hash and found it equal to its own. The behavior is then identified
+ * by its local ID, which is the same on both halves, instead of by name.
+ */
+struct zmk_split_invoke_behavior_data {
+    // All fields are little endian.
+    uint16_t behavior_id;
+    uint16_t position;
+    uint8_t state;
+    uint32_t param1;
+    uint32_t param2;
+} __packed;
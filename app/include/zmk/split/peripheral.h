@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/types.h>
+
+#include <zmk/sensors.h>
+
+/*
+ * Implemented by the selected split transport to forward local events from a peripheral to the
+ * central.
+ */
+
+int zmk_split_position_pressed(uint32_t position, int64_t timestamp);
+int zmk_split_position_released(uint32_t position, int64_t timestamp);
+
+#if ZMK_KEYMAP_HAS_SENSORS
+
+int zmk_split_sensor_triggered(uint8_t sensor_index,
+                               const struct zmk_sensor_channel_data channel_data[],
+                               size_t channel_data_size);
+
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
@@ -18,6 +18,9 @@
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/spi.h>
+#include <zephyr/sys/atomic.h>
+
+#include <zmk/gpio_595.h>
 
 #define LOG_LEVEL CONFIG_GPIO_LOG_LEVEL
 #include <zephyr/logging/log.h>
@@ -38,9 +41,24 @@ struct reg_595_drv_data {
     /* gpio_driver_data needs to be first */
     struct gpio_driver_config data;
 
+    const struct device *dev;
+
+    /* Serializes writes to the chain */
     struct k_sem lock;
 
+    /* Protects the shadow register, which may be changed from an ISR */
+    struct k_spinlock shadow_lock;
+
+    /* State the outputs should have. Changes are written out by reg_595_flush() */
     uint32_t gpio_cache;
+
+    /* State last written to the chain */
+    uint32_t written;
+
+    /* While set, changes only update gpio_cache until zmk_gpio_595_flush() */
+    atomic_t deferred;
+
+    struct k_work flush_work;
 };
 
 static int reg_595_write_registers(const struct device *dev, uint32_t value) {
@@ -68,10 +86,81 @@ static int reg_595_write_registers(const struct device *dev, uint32_t value) {
         return ret;
     }
 
-    drv_data->gpio_cache = value;
+    drv_data->written = value;
     return 0;
 }
 
+/**
+ * @brief Write the shadow register to the chain, if it has changed since the last write
+ *
+ * Any number of changes made since the last flush go out in a single SPI transaction.
+ *
+ * @param dev Device struct of the 595
+ *
+ * @return 0 if successful, failed otherwise
+ */
+static int reg_595_flush(const struct device *dev) {
+    struct reg_595_drv_data *const drv_data = (struct reg_595_drv_data *const)dev->data;
+    uint32_t value;
+    int ret = 0;
+
+    k_sem_take(&drv_data->lock, K_FOREVER);
+
+    K_SPINLOCK(&drv_data->shadow_lock) { value = drv_data->gpio_cache; }
+
+    if (value != drv_data->written) {
+        ret = reg_595_write_registers(dev, value);
+    }
+
+    k_sem_give(&drv_data->lock);
+    return ret;
+}
+
+static void reg_595_flush_work_handler(struct k_work *work) {
+    struct reg_595_drv_data *drv_data = CONTAINER_OF(work, struct reg_595_drv_data, flush_work);
+
+    /* If writes were deferred since this was submitted, zmk_gpio_595_flush() writes the change */
+    if (atomic_get(&drv_data->deferred)) {
+        return;
+    }
+
+    reg_595_flush(drv_data->dev);
+}
+
+/**
+ * @brief Update the shadow register, then write it out unless writes are deferred
+ *
+ * SPI can't be used from an ISR, so changes made from one are written out from the system work
+ * queue instead. They are combined with any other changes made before then. While writes are
+ * deferred, changes from an ISR are left for zmk_gpio_595_flush() like any others.
+ *
+ * @param dev Device struct of the 595
+ * @param mask Pins to change
+ * @param value New values of the pins in mask
+ * @param toggle Pins to invert after applying mask and value
+ *
+ * @return 0 if successful, failed otherwise
+ */
+static int reg_595_update(const struct device *dev, uint32_t mask, uint32_t value,
+                          uint32_t toggle) {
+    struct reg_595_drv_data *const drv_data = (struct reg_595_drv_data *const)dev->data;
+
+    K_SPINLOCK(&drv_data->shadow_lock) {
+        drv_data->gpio_cache = ((drv_data->gpio_cache & ~mask) | (mask & value)) ^ toggle;
+    }
+
+    if (atomic_get(&drv_data->deferred)) {
+        return 0;
+    }
+
+    if (k_is_in_isr()) {
+        k_work_submit(&drv_data->flush_work);
+        return 0;
+    }
+
+    return reg_595_flush(dev);
+}
+
 /**
  * @brief Setup the pin direction (input or output)
  *
@@ -112,53 +201,19 @@ static int reg_595_pin_config(const struct device *dev, gpio_pin_t pin, gpio_fla
 static int reg_595_port_get_raw(const struct device *dev, uint32_t *value) { return -ENOTSUP; }
 
 static int reg_595_port_set_masked_raw(const struct device *dev, uint32_t mask, uint32_t value) {
-    struct reg_595_drv_data *const drv_data = (struct reg_595_drv_data *const)dev->data;
-    uint32_t buf;
-    int ret;
-
-    /* Can't do SPI bus operations from an ISR */
-    if (k_is_in_isr()) {
-        return -EWOULDBLOCK;
-    }
-
-    k_sem_take(&drv_data->lock, K_FOREVER);
-
-    buf = drv_data->gpio_cache;
-    buf = (buf & ~mask) | (mask & value);
-
-    ret = reg_595_write_registers(dev, buf);
-
-    k_sem_give(&drv_data->lock);
-    return ret;
+    return reg_595_update(dev, mask, value, 0);
 }
 
 static int reg_595_port_set_bits_raw(const struct device *dev, uint32_t mask) {
-    return reg_595_port_set_masked_raw(dev, mask, mask);
+    return reg_595_update(dev, mask, mask, 0);
 }
 
 static int reg_595_port_clear_bits_raw(const struct device *dev, uint32_t mask) {
-    return reg_595_port_set_masked_raw(dev, mask, 0);
+    return reg_595_update(dev, mask, 0, 0);
 }
 
 static int reg_595_port_toggle_bits(const struct device *dev, uint32_t mask) {
-    struct reg_595_drv_data *const drv_data = (struct reg_595_drv_data *const)dev->data;
-    uint32_t buf;
-    int ret;
-
-    /* Can't do SPI bus operations from an ISR */
-    if (k_is_in_isr()) {
-        return -EWOULDBLOCK;
-    }
-
-    k_sem_take(&drv_data->lock, K_FOREVER);
-
-    buf = drv_data->gpio_cache;
-    buf ^= mask;
-
-    ret = reg_595_write_registers(dev, buf);
-
-    k_sem_give(&drv_data->lock);
-    return ret;
+    return reg_595_update(dev, 0, 0, mask);
 }
 
 static const struct gpio_driver_api api_table = {
@@ -170,6 +225,33 @@ static const struct gpio_driver_api api_table = {
     .port_toggle_bits = reg_595_port_toggle_bits,
 };
 
+int zmk_gpio_595_defer(const struct device *dev) {
+    struct reg_595_drv_data *const drv_data = (struct reg_595_drv_data *const)dev->data;
+
+    if (dev->api != &api_table) {
+        return -ENOTSUP;
+    }
+
+    atomic_set(&drv_data->deferred, true);
+    return 0;
+}
+
+int zmk_gpio_595_flush(const struct device *dev) {
+    struct reg_595_drv_data *const drv_data = (struct reg_595_drv_data *const)dev->data;
+
+    if (dev->api != &api_table) {
+        return -ENOTSUP;
+    }
+
+    /* Can't do SPI bus operations from an ISR */
+    if (k_is_in_isr()) {
+        return -EWOULDBLOCK;
+    }
+
+    atomic_set(&drv_data->deferred, false);
+    return reg_595_flush(dev);
+}
+
 /**
  * @brief Initialization function of 595
  *
@@ -185,9 +267,12 @@ static int reg_595_init(const struct device *dev) {
         return -ENODEV;
     }
 
+    drv_data->dev = dev;
     k_sem_init(&drv_data->lock, 1, 1);
+    k_work_init(&drv_data->flush_work, reg_595_flush_work_handler);
 
-    return 0;
+    /* The registers power up in an unknown state. Clear them so they match the shadow. */
+    return reg_595_write_registers(dev, 0);
 }
 
 #define GPIO_PORT_PIN_MASK_FROM_NGPIOS(ngpios) ((gpio_port_pins_t)(((uint64_t)1 << (ngpios)) - 1U))
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_gpio_595
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/kernel.h>
+
+#include <zmk/gpio_595_emul.h>
+
+struct emul_595_data {
+    struct k_spinlock lock;
+    uint32_t outputs;
+    uint32_t writes;
+};
+
+struct emul_595_config {
+    uint32_t mask;
+};
+
+uint32_t emul_595_get_outputs(const struct emul *target) {
+    struct emul_595_data *data = target->data;
+    uint32_t outputs;
+
+    K_SPINLOCK(&data->lock) { outputs = data->outputs; }
+
+    return outputs;
+}
+
+uint32_t emul_595_get_writes(const struct emul *target) {
+    struct emul_595_data *data = target->data;
+
+    return data->writes;
+}
+
+static int emul_595_io(const struct emul *target, const struct spi_config *spi_config,
+                       const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs) {
+    const struct emul_595_config *config = target->cfg;
+    struct emul_595_data *data = target->data;
+
+    if (!tx_bufs) {
+        return -EINVAL;
+    }
+
+    K_SPINLOCK(&data->lock) {
+        data->writes++;
+
+        // Each byte shifted in pushes the ones before it further down the chain, so the last byte
+        // ends up in the register nearest the MCU, which holds the lowest outputs.
+        for (int i = 0; i < tx_bufs->count; i++) {
+            const struct spi_buf *buf = &tx_bufs->buffers[i];
+            const uint8_t *in = buf->buf;
+
+            for (int b = 0; b < buf->len; b++) {
+                data->outputs = ((data->outputs << 8) | (in ? in[b] : 0)) & config->mask;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static const struct spi_emul_api emul_595_api = {
+    .io = emul_595_io,
+};
+
+static int emul_595_init(const struct emul *target, const struct device *parent) {
+    struct emul_595_data *data = target->data;
+
+    data->outputs = 0;
+    data->writes = 0;
+
+    return 0;
+}
+
+#define EMUL_595_INIT(n)                                                                           \
+    static struct emul_595_data emul_595_data_##n;                                                 \
+                                                                                                   \
+    static const struct emul_595_config emul_595_config_##n = {                                    \
+        .mask = (uint32_t)BIT64_MASK(DT_INST_PROP(n, ngpios)),                                     \
+    };                                                                                             \
+                                                                                                   \
+    EMUL_DT_INST_DEFINE(n, emul_595_init, &emul_595_data_##n, &emul_595_config_##n,                \
+                        &emul_595_api, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(EMUL_595_INIT)
@@ -17,6 +17,7 @@
 #include <zephyr/init.h>
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_utils.h>
 #include <zephyr/drivers/i2c.h>
 
 #define LOG_LEVEL CONFIG_GPIO_LOG_LEVEL
@@ -40,6 +41,12 @@ struct max7318_config {
 
     struct i2c_dt_spec i2c_bus;
     uint8_t ngpios;
+
+    // MCU pin connected to the INT output, if any
+    struct gpio_dt_spec int_gpio;
+
+    // Reuse the last input read while the INT output is inactive
+    bool input_cache;
 };
 
 // Runtime driver data
@@ -47,6 +54,8 @@ struct max7318_drv_data {
     // gpio_driver_data needs to be first
     struct gpio_driver_config data;
 
+    const struct device *dev;
+
     struct k_sem lock;
 
     struct {
@@ -54,6 +63,29 @@ struct max7318_drv_data {
         uint16_t config;
         uint16_t output;
     } reg_cache;
+
+    // Last value read from the input registers, and whether it can still be used for the input
+    // cache. Writes to the chip invalidate it, since its own outputs may drive its inputs.
+    uint16_t input;
+    bool input_valid;
+
+    sys_slist_t callbacks;
+    struct gpio_callback int_callback;
+    struct k_work int_work;
+
+    // Pin interrupt configuration, which may be changed from an ISR
+    struct k_spinlock irq_lock;
+    struct {
+        uint16_t enabled;
+        // Level rather than edge triggered
+        uint16_t level;
+        // Triggered by a high level or rising edge
+        uint16_t high;
+        // Triggered by a low level or falling edge
+        uint16_t low;
+        // Inputs as last seen by the interrupt work, for detecting edges
+        uint16_t last;
+    } irq;
 };
 
 /**
@@ -114,6 +146,37 @@ static int write_registers(const struct device *dev, uint8_t reg, uint16_t value
     return i2c_burst_write_dt(&config->i2c_bus, reg, &data[0], sizeof(data));
 }
 
+/**
+ * @brief Read both input registers into the driver data, unless the cached value is still valid
+ *
+ * The chip asserts INT whenever an input differs from the last time it was read, and reading it
+ * deasserts INT, so the cache is valid for as long as INT stays inactive. Must be called with the
+ * lock held.
+ *
+ * @param dev   The max7318 device.
+ *
+ * @return 0 if successful, failed otherwise.
+ */
+static int read_inputs(const struct device *dev) {
+    const struct max7318_config *config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    if (config->input_cache && drv_data->input_valid &&
+        gpio_pin_get_dt(&config->int_gpio) == 0) {
+        return 0;
+    }
+
+    drv_data->input_valid = false;
+
+    int ret = read_registers(dev, REG_INPUT_PORTA, &drv_data->input);
+    if (ret != 0) {
+        return ret;
+    }
+
+    drv_data->input_valid = true;
+    return 0;
+}
+
 /**
  * @brief Setup the pin direction (input or output)
  *
@@ -143,6 +206,8 @@ static int set_pin_direction(const struct device *dev, uint32_t pin, int flags)
         *dir |= BIT(pin);
     }
 
+    drv_data->input_valid = false;
+
     int ret = write_registers(dev, REG_OUTPUT_PORTA, *output);
     if (ret != 0) {
         return ret;
@@ -215,15 +280,11 @@ static int max7318_port_get_raw(const struct device *dev, uint32_t *value) {
 
     k_sem_take(&drv_data->lock, K_FOREVER);
 
-    uint16_t buf = 0;
-    int ret = read_registers(dev, REG_INPUT_PORTA, &buf);
-    if (ret != 0) {
-        goto done;
+    int ret = read_inputs(dev);
+    if (ret == 0) {
+        *value = drv_data->input;
     }
 
-    *value = buf;
-
-done:
     k_sem_give(&drv_data->lock);
     return ret;
 }
@@ -241,6 +302,8 @@ static int max7318_port_set_masked_raw(const struct device *dev, uint32_t mask,
     uint16_t buf = drv_data->reg_cache.output;
     buf = (buf & ~mask) | (mask & value);
 
+    drv_data->input_valid = false;
+
     int ret = write_registers(dev, REG_OUTPUT_PORTA, buf);
     if (ret == 0) {
         drv_data->reg_cache.output = buf;
@@ -271,6 +334,8 @@ static int max7318_port_toggle_bits(const struct device *dev, uint32_t mask) {
     uint16_t buf = drv_data->reg_cache.output;
     buf ^= mask;
 
+    drv_data->input_valid = false;
+
     int ret = write_registers(dev, REG_OUTPUT_PORTA, buf);
     if (ret == 0) {
         drv_data->reg_cache.output = buf;
@@ -282,7 +347,78 @@ static int max7318_port_toggle_bits(const struct device *dev, uint32_t mask) {
 
 static int max7318_pin_interrupt_configure(const struct device *dev, gpio_pin_t pin,
                                            enum gpio_int_mode mode, enum gpio_int_trig trig) {
-    return -ENOTSUP;
+    const struct max7318_config *config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+    uint16_t enabled;
+
+    if (!config->int_gpio.port) {
+        return -ENOTSUP;
+    }
+
+    K_SPINLOCK(&drv_data->irq_lock) {
+        WRITE_BIT(drv_data->irq.enabled, pin, mode != GPIO_INT_MODE_DISABLED);
+        WRITE_BIT(drv_data->irq.level, pin, mode == GPIO_INT_MODE_LEVEL);
+        WRITE_BIT(drv_data->irq.high, pin, (trig & GPIO_INT_TRIG_HIGH) != 0U);
+        WRITE_BIT(drv_data->irq.low, pin, (trig & GPIO_INT_TRIG_LOW) != 0U);
+        enabled = drv_data->irq.enabled;
+    }
+
+    // A pin may already be at the level it's waiting for, which won't assert INT, so check the
+    // inputs once now.
+    if (mode == GPIO_INT_MODE_LEVEL) {
+        k_work_submit(&drv_data->int_work);
+    }
+
+    // Only wake up for changes while someone is interested in them.
+    return gpio_pin_interrupt_configure_dt(&config->int_gpio,
+                                           enabled ? GPIO_INT_EDGE_TO_ACTIVE : GPIO_INT_DISABLE);
+}
+
+static int max7318_manage_callback(const struct device *dev, struct gpio_callback *callback,
+                                   bool set) {
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    return gpio_manage_callback(&drv_data->callbacks, callback, set);
+}
+
+static void max7318_int_work_handler(struct k_work *work) {
+    struct max7318_drv_data *const drv_data =
+        CONTAINER_OF(work, struct max7318_drv_data, int_work);
+    const struct device *dev = drv_data->dev;
+    uint16_t input;
+    uint16_t fired;
+
+    // Reading the inputs deasserts INT.
+    k_sem_take(&drv_data->lock, K_FOREVER);
+    int ret = read_inputs(dev);
+    input = drv_data->input;
+    k_sem_give(&drv_data->lock);
+
+    if (ret != 0) {
+        LOG_ERR("failed to read inputs for interrupt (%d)", ret);
+        return;
+    }
+
+    K_SPINLOCK(&drv_data->irq_lock) {
+        const uint16_t triggered = (drv_data->irq.high & input) | (drv_data->irq.low & ~input);
+        const uint16_t changed = drv_data->irq.last ^ input;
+
+        fired = drv_data->irq.enabled & triggered & (drv_data->irq.level | changed);
+        drv_data->irq.last = input;
+    }
+
+    if (fired) {
+        gpio_fire_callbacks(&drv_data->callbacks, dev, fired);
+    }
+}
+
+static void max7318_int_callback_handler(const struct device *port, struct gpio_callback *cb,
+                                         gpio_port_pins_t pins) {
+    struct max7318_drv_data *const drv_data =
+        CONTAINER_OF(cb, struct max7318_drv_data, int_callback);
+
+    // Can't do I2C bus operations from an ISR
+    k_work_submit(&drv_data->int_work);
 }
 
 static const struct gpio_driver_api api_table = {
@@ -293,6 +429,7 @@ static const struct gpio_driver_api api_table = {
     .port_clear_bits_raw = max7318_port_clear_bits_raw,
     .port_toggle_bits = max7318_port_toggle_bits,
     .pin_interrupt_configure = max7318_pin_interrupt_configure,
+    .manage_callback = max7318_manage_callback,
 };
 
 /**
@@ -310,9 +447,41 @@ static int max7318_init(const struct device *dev) {
         return -EINVAL;
     }
 
+    drv_data->dev = dev;
+    k_sem_init(&drv_data->lock, 1, 1);
+    k_work_init(&drv_data->int_work, max7318_int_work_handler);
+
+    if (config->int_gpio.port) {
+        if (!gpio_is_ready_dt(&config->int_gpio)) {
+            LOG_WRN("interrupt gpio not ready!");
+            return -EINVAL;
+        }
+
+        int ret = gpio_pin_configure_dt(&config->int_gpio, GPIO_INPUT);
+        if (ret != 0) {
+            LOG_ERR("failed to configure interrupt gpio (%d)", ret);
+            return ret;
+        }
+
+        gpio_init_callback(&drv_data->int_callback, max7318_int_callback_handler,
+                           BIT(config->int_gpio.pin));
+        ret = gpio_add_callback(config->int_gpio.port, &drv_data->int_callback);
+        if (ret != 0) {
+            LOG_ERR("failed to add interrupt callback (%d)", ret);
+            return ret;
+        }
+
+        // Read the inputs once to deassert INT and to have a starting point for edges.
+        ret = read_registers(dev, REG_INPUT_PORTA, &drv_data->input);
+        if (ret != 0) {
+            return ret;
+        }
+
+        drv_data->irq.last = drv_data->input;
+    }
+
     LOG_INF("device initialised at 0x%x", config->i2c_bus.addr);
 
-    k_sem_init(&drv_data->lock, 1, 1);
     return 0;
 }
 
@@ -322,9 +491,16 @@ static int max7318_init(const struct device *dev) {
     GPIO_PORT_PIN_MASK_FROM_NGPIOS(DT_INST_PROP(inst, ngpios))
 
 #define MAX7318_INIT(inst)                                                                         \
+    BUILD_ASSERT(!DT_INST_PROP(inst, input_cache) ||                                               \
+                     DT_INST_NODE_HAS_PROP(inst, interrupt_gpios),                                 \
+                 "input-cache requires interrupt-gpios");                                          \
+                                                                                                   \
     static struct max7318_config max7318_##inst##_config = {                                       \
         .common = {.port_pin_mask = GPIO_PORT_PIN_MASK_FROM_DT_INST(inst)},                        \
-        .i2c_bus = I2C_DT_SPEC_INST_GET(inst)};                                                    \
+        .i2c_bus = I2C_DT_SPEC_INST_GET(inst),                                                     \
+        .int_gpio = GPIO_DT_SPEC_INST_GET_OR(inst, interrupt_gpios, {0}),                          \
+        .input_cache = DT_INST_PROP(inst, input_cache),                                            \
+    };                                                                                             \
                                                                                                    \
     static struct max7318_drv_data max7318_##inst##_drvdata = {                                    \
         /* Default for registers according to datasheet */                                         \
@@ -0,0 +1,497 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "kscan_gpio.h"
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include <zmk/debounce.h>
+#include <zmk/kscan_timestamp.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define DT_DRV_COMPAT zmk_kscan_74hc165
+
+/*
+ * Reads keys through a chain of 74HC165 parallel-in, serial-out shift registers on a SPI bus.
+ * Pulsing the load pin latches every input at once, then a single SPI read shifts them all in,
+ * starting with the register connected to the MCU.
+ *
+ * With output-gpios, the keys form a matrix: each output is set active in turn and all inputs
+ * are read for it, so the outputs are the rows and the inputs are the columns. Without them, each
+ * input is one key in a single row.
+ */
+
+#define INST_HAS_OUTPUTS(n) DT_INST_NODE_HAS_PROP(n, output_gpios)
+#define INST_OUTPUTS_LEN(n) DT_INST_PROP_LEN_OR(n, output_gpios, 0)
+#define INST_ROWS_LEN(n) MAX(INST_OUTPUTS_LEN(n), 1)
+#define INST_INPUTS_LEN(n) DT_INST_PROP(n, inputs)
+#define INST_REGISTERS_LEN(n) DIV_ROUND_UP(INST_INPUTS_LEN(n), 8)
+#define INST_MATRIX_WORDS(n)                                                                       \
+    DIV_ROUND_UP(INST_ROWS_LEN(n) * INST_INPUTS_LEN(n), DEBOUNCE_PACKED_WIDTH)
+
+#if CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS >= 0
+#define INST_DEBOUNCE_PRESS_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS
+#else
+#define INST_DEBOUNCE_PRESS_MS(n) DT_INST_PROP(n, debounce_press_ms)
+#endif
+
+#if CONFIG_ZMK_KSCAN_DEBOUNCE_RELEASE_MS >= 0
+#define INST_DEBOUNCE_RELEASE_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_RELEASE_MS
+#else
+#define INST_DEBOUNCE_RELEASE_MS(n) DT_INST_PROP(n, debounce_release_ms)
+#endif
+
+#define KSCAN_74HC165_OUTPUT_CFG_INIT(idx, inst_idx)                                               \
+    KSCAN_GPIO_GET_BY_IDX(DT_DRV_INST(inst_idx), output_gpios, idx)
+
+struct kscan_74hc165_data {
+    const struct device *dev;
+    kscan_callback_t callback;
+    zmk_kscan_timestamp_callback_t timestamp_callback;
+    struct k_work_delayable work;
+    struct gpio_callback irq_callback;
+    /** Timestamp of the current or scheduled scan. */
+    int64_t scan_time;
+    /** Whether all outputs are set active for the interrupt. */
+    bool outputs_active;
+    /** Raw input registers as read from the chain. Array of length config->registers */
+    uint8_t *registers;
+    /**
+     * Current state of the keys as a flattened 2D bit array of config->rows rows of
+     * config->inputs columns, packed DEBOUNCE_PACKED_WIDTH keys to an element. Array of length
+     * config->matrix_words
+     */
+    struct zmk_debounce_packed_state *matrix_state;
+    /** Keys read as pressed in the current scan, laid out the same as matrix_state. */
+    uint32_t *matrix_active;
+};
+
+struct kscan_74hc165_config {
+    struct spi_dt_spec bus;
+    struct gpio_dt_spec load_gpio;
+    struct gpio_dt_spec interrupt_gpio;
+    struct kscan_gpio_list outputs;
+    struct zmk_debounce_config debounce_config;
+    size_t rows;
+    size_t inputs;
+    size_t registers;
+    size_t matrix_words;
+    int32_t debounce_scan_period_ms;
+    int32_t poll_period_ms;
+    bool inputs_active_low;
+};
+
+static bool kscan_74hc165_use_interrupt(const struct kscan_74hc165_config *config) {
+    return config->interrupt_gpio.port != NULL;
+}
+
+static int kscan_74hc165_set_all_outputs(const struct device *dev, const int value) {
+    const struct kscan_74hc165_config *config = dev->config;
+
+    for (int i = 0; i < config->outputs.len; i++) {
+        const struct gpio_dt_spec *gpio = &config->outputs.gpios[i].spec;
+
+        int err = gpio_pin_set_dt(gpio, value);
+        if (err) {
+            LOG_ERR("Failed to set output %i to %i: %i", i, value, err);
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+static int kscan_74hc165_interrupt_enable(const struct device *dev) {
+    const struct kscan_74hc165_config *config = dev->config;
+    struct kscan_74hc165_data *data = dev->data;
+
+    // While waiting for the interrupt, set all outputs active so any pressed key will trigger it.
+    int err = kscan_74hc165_set_all_outputs(dev, 1);
+    if (err) {
+        return err;
+    }
+
+    data->outputs_active = true;
+
+    return gpio_pin_interrupt_configure_dt(&config->interrupt_gpio, GPIO_INT_LEVEL_ACTIVE);
+}
+
+static int kscan_74hc165_outputs_release(const struct device *dev) {
+    struct kscan_74hc165_data *data = dev->data;
+
+    if (!data->outputs_active) {
+        return 0;
+    }
+
+    // Set all outputs inactive so kscan_74hc165_read() can scan them one by one.
+    int err = kscan_74hc165_set_all_outputs(dev, 0);
+    if (err) {
+        return err;
+    }
+
+    data->outputs_active = false;
+    return 0;
+}
+
+static int kscan_74hc165_interrupt_disable(const struct device *dev) {
+    const struct kscan_74hc165_config *config = dev->config;
+
+    int err = gpio_pin_interrupt_configure_dt(&config->interrupt_gpio, GPIO_INT_DISABLE);
+    if (err) {
+        return err;
+    }
+
+    return kscan_74hc165_outputs_release(dev);
+}
+
+static void kscan_74hc165_irq_callback_handler(const struct device *port, struct gpio_callback *cb,
+                                               const gpio_port_pins_t pin) {
+    struct kscan_74hc165_data *data = CONTAINER_OF(cb, struct kscan_74hc165_data, irq_callback);
+    const struct kscan_74hc165_config *config = data->dev->config;
+
+    // Disable the interrupt temporarily to avoid re-entry while we scan. The outputs are left for
+    // the scan to handle, since they may be on a bus that can't be used from an ISR.
+    gpio_pin_interrupt_configure_dt(&config->interrupt_gpio, GPIO_INT_DISABLE);
+
+    data->scan_time = k_uptime_get();
+
+    k_work_reschedule(&data->work, K_NO_WAIT);
+}
+
+/**
+ * Latches all inputs and shifts them in with one SPI transaction.
+ */
+static int kscan_74hc165_read_registers(const struct device *dev) {
+    const struct kscan_74hc165_config *config = dev->config;
+    struct kscan_74hc165_data *data = dev->data;
+
+    int err = gpio_pin_set_dt(&config->load_gpio, 1);
+    if (!err) {
+        err = gpio_pin_set_dt(&config->load_gpio, 0);
+    }
+    if (err) {
+        LOG_ERR("Failed to pulse the load pin: %i", err);
+        return err;
+    }
+
+    const struct spi_buf rx_buf = {.buf = data->registers, .len = config->registers};
+    const struct spi_buf_set rx = {.buffers = &rx_buf, .count = 1};
+
+    err = spi_read_dt(&config->bus, &rx);
+    if (err) {
+        LOG_ERR("Failed to read the input registers: %i", err);
+        return err;
+    }
+
+    if (config->inputs_active_low) {
+        for (int i = 0; i < config->registers; i++) {
+            data->registers[i] = ~data->registers[i];
+        }
+    }
+
+    return 0;
+}
+
+static void kscan_74hc165_store_row(const struct device *dev, const int row) {
+    const struct kscan_74hc165_config *config = dev->config;
+    struct kscan_74hc165_data *data = dev->data;
+
+    for (int i = 0; i < config->inputs; i++) {
+        if (data->registers[i / 8] & BIT(i % 8)) {
+            const int index = (row * config->inputs) + i;
+
+            data->matrix_active[index / DEBOUNCE_PACKED_WIDTH] |=
+                BIT(index % DEBOUNCE_PACKED_WIDTH);
+        }
+    }
+}
+
+static void kscan_74hc165_read_continue(const struct device *dev) {
+    const struct kscan_74hc165_config *config = dev->config;
+    struct kscan_74hc165_data *data = dev->data;
+
+    data->scan_time += config->debounce_scan_period_ms;
+
+    k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
+}
+
+static void kscan_74hc165_read_end(const struct device *dev) {
+    const struct kscan_74hc165_config *config = dev->config;
+    struct kscan_74hc165_data *data = dev->data;
+
+    if (kscan_74hc165_use_interrupt(config)) {
+        // Return to waiting for an interrupt.
+        kscan_74hc165_interrupt_enable(dev);
+        return;
+    }
+
+    data->scan_time += config->poll_period_ms;
+
+    // Return to polling slowly.
+    k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
+}
+
+static int kscan_74hc165_read(const struct device *dev) {
+    const struct kscan_74hc165_config *config = dev->config;
+    struct kscan_74hc165_data *data = dev->data;
+    const int64_t read_time = k_uptime_get();
+
+    int err = kscan_74hc165_outputs_release(dev);
+    if (err) {
+        return err;
+    }
+
+    memset(data->matrix_active, 0, config->matrix_words * sizeof(data->matrix_active[0]));
+
+    if (config->outputs.len == 0) {
+        err = kscan_74hc165_read_registers(dev);
+        if (err) {
+            return err;
+        }
+
+        kscan_74hc165_store_row(dev, 0);
+    }
+
+    const struct gpio_dt_spec *active_output = NULL;
+
+    for (int i = 0; i < config->outputs.len; i++) {
+        const struct gpio_dt_spec *gpio = &config->outputs.gpios[i].spec;
+
+        err = kscan_gpio_switch_output(active_output, gpio);
+        if (err) {
+            LOG_ERR("Failed to set output %i active: %i", i, err);
+            return err;
+        }
+
+        active_output = gpio;
+
+        err = kscan_74hc165_read_registers(dev);
+        if (err) {
+            return err;
+        }
+
+        kscan_74hc165_store_row(dev, i);
+    }
+
+    err = kscan_gpio_switch_output(active_output, NULL);
+    if (err) {
+        LOG_ERR("Failed to set last output inactive: %i", err);
+        return err;
+    }
+
+    // Process the new state.
+    uint32_t continue_scan = 0;
+
+    for (int i = 0; i < config->matrix_words; i++) {
+        struct zmk_debounce_packed_state *state = &data->matrix_state[i];
+        uint32_t changed =
+            zmk_debounce_packed_update(state, data->matrix_active[i],
+                                       config->debounce_scan_period_ms, &config->debounce_config);
+        const uint32_t pressed = zmk_debounce_packed_get_pressed(state);
+
+        while (changed) {
+            const int bit = u32_count_trailing_zeros(changed);
+            const int index = i * DEBOUNCE_PACKED_WIDTH + bit;
+            const int r = index / config->inputs;
+            const int c = index % config->inputs;
+
+            changed &= changed - 1;
+
+            LOG_DBG("Sending event at %i,%i state %s", r, c, (pressed & BIT(bit)) ? "on" : "off");
+            zmk_kscan_timestamp_report(dev, data->callback, data->timestamp_callback, r, c,
+                                       pressed & BIT(bit), read_time);
+        }
+
+        continue_scan |= zmk_debounce_packed_get_active(state);
+    }
+
+    if (continue_scan) {
+        // At least one key is pressed or the debouncer has not yet decided if
+        // it is pressed. Poll quickly until everything is released.
+        kscan_74hc165_read_continue(dev);
+    } else {
+        // All keys are released. Return to normal.
+        kscan_74hc165_read_end(dev);
+    }
+
+    return 0;
+}
+
+static void kscan_74hc165_work_handler(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct kscan_74hc165_data *data = CONTAINER_OF(dwork, struct kscan_74hc165_data, work);
+    kscan_74hc165_read(data->dev);
+}
+
+static int kscan_74hc165_configure(const struct device *dev, const kscan_callback_t callback) {
+    struct kscan_74hc165_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->callback = callback;
+    data->timestamp_callback = NULL;
+    return 0;
+}
+
+static int kscan_74hc165_configure_timestamp(const struct device *dev,
+                                             const zmk_kscan_timestamp_callback_t callback) {
+    struct kscan_74hc165_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->timestamp_callback = callback;
+    return 0;
+}
+
+static int kscan_74hc165_enable(const struct device *dev) {
+    struct kscan_74hc165_data *data = dev->data;
+
+    data->scan_time = k_uptime_get();
+
+    // Read will automatically start interrupts/polling once done.
+    return kscan_74hc165_read(dev);
+}
+
+static int kscan_74hc165_disable(const struct device *dev) {
+    const struct kscan_74hc165_config *config = dev->config;
+    struct kscan_74hc165_data *data = dev->data;
+
+    k_work_cancel_delayable(&data->work);
+
+    if (kscan_74hc165_use_interrupt(config)) {
+        return kscan_74hc165_interrupt_disable(dev);
+    }
+
+    return 0;
+}
+
+static int kscan_74hc165_init_gpio(const struct gpio_dt_spec *gpio, const gpio_flags_t flags) {
+    if (!device_is_ready(gpio->port)) {
+        LOG_ERR("GPIO is not ready: %s", gpio->port->name);
+        return -ENODEV;
+    }
+
+    int err = gpio_pin_configure_dt(gpio, flags);
+    if (err) {
+        LOG_ERR("Unable to configure pin %u on %s: %i", gpio->pin, gpio->port->name, err);
+        return err;
+    }
+
+    return 0;
+}
+
+static int kscan_74hc165_init(const struct device *dev) {
+    const struct kscan_74hc165_config *config = dev->config;
+    struct kscan_74hc165_data *data = dev->data;
+
+    data->dev = dev;
+
+    if (!spi_is_ready_dt(&config->bus)) {
+        LOG_ERR("SPI bus %s is not ready", config->bus.bus->name);
+        return -ENODEV;
+    }
+
+    int err = kscan_74hc165_init_gpio(&config->load_gpio, GPIO_OUTPUT_INACTIVE);
+    if (err) {
+        return err;
+    }
+
+    for (int i = 0; i < config->outputs.len; i++) {
+        err = kscan_74hc165_init_gpio(&config->outputs.gpios[i].spec, GPIO_OUTPUT_INACTIVE);
+        if (err) {
+            return err;
+        }
+    }
+
+    if (kscan_74hc165_use_interrupt(config)) {
+        err = kscan_74hc165_init_gpio(&config->interrupt_gpio, GPIO_INPUT);
+        if (err) {
+            return err;
+        }
+
+        gpio_init_callback(&data->irq_callback, kscan_74hc165_irq_callback_handler,
+                           BIT(config->interrupt_gpio.pin));
+        err = gpio_add_callback(config->interrupt_gpio.port, &data->irq_callback);
+        if (err) {
+            LOG_ERR("Error adding the interrupt callback: %i", err);
+            return err;
+        }
+    }
+
+    k_work_init_delayable(&data->work, kscan_74hc165_work_handler);
+
+    return 0;
+}
+
+static const struct kscan_driver_api kscan_74hc165_api = {
+    .config = kscan_74hc165_configure,
+    .enable_callback = kscan_74hc165_enable,
+    .disable_callback = kscan_74hc165_disable,
+};
+
+#define KSCAN_74HC165_INIT(n)                                                                      \
+    BUILD_ASSERT(INST_DEBOUNCE_PRESS_MS(n) <= DEBOUNCE_COUNTER_MAX,                                \
+                 "ZMK_KSCAN_DEBOUNCE_PRESS_MS or debounce-press-ms is too large");                 \
+    BUILD_ASSERT(INST_DEBOUNCE_RELEASE_MS(n) <= DEBOUNCE_COUNTER_MAX,                              \
+                 "ZMK_KSCAN_DEBOUNCE_RELEASE_MS or debounce-release-ms is too large");             \
+                                                                                                   \
+    COND_CODE_1(INST_HAS_OUTPUTS(n),                                                               \
+                (static struct kscan_gpio kscan_74hc165_outputs_##n[] = {                          \
+                     LISTIFY(INST_OUTPUTS_LEN(n), KSCAN_74HC165_OUTPUT_CFG_INIT, (, ), n)};),      \
+                ())                                                                                \
+                                                                                                   \
+    static uint8_t kscan_74hc165_registers_##n[INST_REGISTERS_LEN(n)];                             \
+    static struct zmk_debounce_packed_state kscan_74hc165_state_##n[INST_MATRIX_WORDS(n)];         \
+    static uint32_t kscan_74hc165_active_##n[INST_MATRIX_WORDS(n)];                                \
+                                                                                                   \
+    static struct kscan_74hc165_data kscan_74hc165_data_##n = {                                    \
+        .registers = kscan_74hc165_registers_##n,                                                  \
+        .matrix_state = kscan_74hc165_state_##n,                                                   \
+        .matrix_active = kscan_74hc165_active_##n,                                                 \
+    };                                                                                             \
+                                                                                                   \
+    static const struct kscan_74hc165_config kscan_74hc165_config_##n = {                          \
+        .bus = SPI_DT_SPEC_INST_GET(n, SPI_OP_MODE_MASTER | SPI_TRANSFER_MSB | SPI_WORD_SET(8),    \
+                                    0),                                                            \
+        .load_gpio = GPIO_DT_SPEC_INST_GET(n, load_gpios),                                         \
+        .interrupt_gpio = GPIO_DT_SPEC_INST_GET_OR(n, interrupt_gpios, {0}),                       \
+        .outputs = COND_CODE_1(INST_HAS_OUTPUTS(n),                                                \
+                               (KSCAN_GPIO_LIST(kscan_74hc165_outputs_##n)), ({0})),               \
+        .debounce_config =                                                                         \
+            {                                                                                      \
+                .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
+                .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
+                .algorithm = DT_INST_ENUM_IDX(n, debounce_algorithm),                              \
+            },                                                                                     \
+        .rows = INST_ROWS_LEN(n),                                                                  \
+        .inputs = INST_INPUTS_LEN(n),                                                              \
+        .registers = INST_REGISTERS_LEN(n),                                                        \
+        .matrix_words = INST_MATRIX_WORDS(n),                                                      \
+        .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
+        .poll_period_ms = DT_INST_PROP(n, poll_period_ms),                                         \
+        .inputs_active_low = DT_INST_PROP(n, inputs_active_low),                                   \
+    };                                                                                             \
+                                                                                                   \
+    DEVICE_DT_INST_DEFINE(n, &kscan_74hc165_init, NULL, &kscan_74hc165_data_##n,                   \
+                          &kscan_74hc165_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,      \
+                          &kscan_74hc165_api);                                                     \
+    ZMK_KSCAN_TIMESTAMP_API_DEFINE(DT_DRV_INST(n), &kscan_74hc165_configure_timestamp);
+
+DT_INST_FOREACH_STATUS_OKAY(KSCAN_74HC165_INIT);
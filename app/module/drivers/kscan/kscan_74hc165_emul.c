@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_kscan_74hc165
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#if IS_ENABLED(CONFIG_GPIO_EMUL)
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#endif
+
+#include <zmk/kscan_74hc165_emul.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+struct emul_74hc165_data {
+    struct k_spinlock lock;
+    /** Pressed keys, config->registers bytes for each of config->rows rows. */
+    uint8_t *keys;
+    uint32_t reads;
+    uint32_t output_log[EMUL_74HC165_OUTPUT_LOG_LEN];
+    size_t output_log_len;
+};
+
+struct emul_74hc165_config {
+    const struct gpio_dt_spec *outputs;
+    size_t outputs_len;
+    size_t rows;
+    size_t inputs;
+    size_t registers;
+};
+
+int emul_74hc165_set_key(const struct emul *target, int row, int input, bool pressed) {
+    const struct emul_74hc165_config *config = target->cfg;
+    struct emul_74hc165_data *data = target->data;
+
+    if (row < 0 || row >= config->rows || input < 0 || input >= config->inputs) {
+        return -EINVAL;
+    }
+
+    K_SPINLOCK(&data->lock) {
+        WRITE_BIT(data->keys[row * config->registers + input / 8], input % 8, pressed);
+    }
+
+    return 0;
+}
+
+int emul_74hc165_set_input(const struct emul *target, int input, bool level) {
+    return emul_74hc165_set_key(target, 0, input, level);
+}
+
+uint32_t emul_74hc165_get_reads(const struct emul *target) {
+    struct emul_74hc165_data *data = target->data;
+
+    return data->reads;
+}
+
+size_t emul_74hc165_get_output_log(const struct emul *target, uint32_t *masks, size_t len) {
+    struct emul_74hc165_data *data = target->data;
+    size_t count = 0;
+
+    K_SPINLOCK(&data->lock) {
+        count = MIN(len, data->output_log_len);
+        memcpy(masks, data->output_log, count * sizeof(masks[0]));
+        data->output_log_len = 0;
+    }
+
+    return count;
+}
+
+static uint32_t emul_74hc165_active_outputs(const struct emul_74hc165_config *config) {
+    uint32_t active = 0;
+
+#if IS_ENABLED(CONFIG_GPIO_EMUL)
+    for (int i = 0; i < config->outputs_len; i++) {
+        const struct gpio_dt_spec *gpio = &config->outputs[i];
+        const bool active_low = (gpio->dt_flags & GPIO_ACTIVE_LOW) != 0;
+
+        if (gpio_emul_output_get(gpio->port, gpio->pin) == !active_low) {
+            active |= BIT(i);
+        }
+    }
+#endif // IS_ENABLED(CONFIG_GPIO_EMUL)
+
+    return active;
+}
+
+// Value latched by one register: its inputs as set directly, or the keys of the active rows.
+static uint8_t emul_74hc165_latch(const struct emul_74hc165_config *config,
+                                  const struct emul_74hc165_data *data, uint32_t active_outputs,
+                                  size_t reg) {
+    if (config->outputs_len == 0) {
+        return data->keys[reg];
+    }
+
+    uint8_t value = 0;
+    for (int row = 0; row < config->rows; row++) {
+        if (active_outputs & BIT(row)) {
+            value |= data->keys[row * config->registers + reg];
+        }
+    }
+
+    return value;
+}
+
+static int emul_74hc165_io(const struct emul *target, const struct spi_config *spi_config,
+                           const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs) {
+    const struct emul_74hc165_config *config = target->cfg;
+    struct emul_74hc165_data *data = target->data;
+    const uint32_t active_outputs = emul_74hc165_active_outputs(config);
+    size_t offset = 0;
+
+    if (!rx_bufs) {
+        return -EINVAL;
+    }
+
+    K_SPINLOCK(&data->lock) {
+        data->reads++;
+
+        if (data->output_log_len < EMUL_74HC165_OUTPUT_LOG_LEN) {
+            data->output_log[data->output_log_len++] = active_outputs;
+        }
+
+        // The chain shifts in its registers in order, then whatever is wired to the serial input
+        // of the last one, which is taken to be tied low.
+        for (int i = 0; i < rx_bufs->count; i++) {
+            const struct spi_buf *buf = &rx_bufs->buffers[i];
+            uint8_t *out = buf->buf;
+
+            for (int b = 0; b < buf->len; b++, offset++) {
+                const uint8_t value = offset < config->registers
+                                          ? emul_74hc165_latch(config, data, active_outputs, offset)
+                                          : 0;
+
+                if (out) {
+                    out[b] = value;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+static const struct spi_emul_api emul_74hc165_api = {
+    .io = emul_74hc165_io,
+};
+
+static int emul_74hc165_init(const struct emul *target, const struct device *parent) {
+    const struct emul_74hc165_config *config = target->cfg;
+    struct emul_74hc165_data *data = target->data;
+
+    if (config->outputs_len > 0 && !IS_ENABLED(CONFIG_GPIO_EMUL)) {
+        LOG_ERR("The outputs of an emulated 74HC165 matrix must be emulated GPIOs");
+        return -ENOTSUP;
+    }
+
+    memset(data->keys, 0, config->rows * config->registers);
+    data->reads = 0;
+    data->output_log_len = 0;
+
+    return 0;
+}
+
+#define EMUL_74HC165_OUTPUTS_LEN(n) DT_INST_PROP_LEN_OR(n, output_gpios, 0)
+#define EMUL_74HC165_ROWS(n) MAX(EMUL_74HC165_OUTPUTS_LEN(n), 1)
+#define EMUL_74HC165_REGISTERS(n) DIV_ROUND_UP(DT_INST_PROP(n, inputs), 8)
+
+#define EMUL_74HC165_OUTPUT_INIT(idx, n) GPIO_DT_SPEC_INST_GET_BY_IDX(n, output_gpios, idx)
+
+#define EMUL_74HC165_INIT(n)                                                                       \
+    COND_CODE_1(DT_INST_NODE_HAS_PROP(n, output_gpios),                                            \
+                (static const struct gpio_dt_spec emul_74hc165_outputs_##n[] = {                   \
+                     LISTIFY(EMUL_74HC165_OUTPUTS_LEN(n), EMUL_74HC165_OUTPUT_INIT, (, ), n)};),   \
+                ())                                                                                \
+                                                                                                   \
+    static uint8_t emul_74hc165_keys_##n[EMUL_74HC165_ROWS(n) * EMUL_74HC165_REGISTERS(n)];        \
+                                                                                                   \
+    static struct emul_74hc165_data emul_74hc165_data_##n = {                                      \
+        .keys = emul_74hc165_keys_##n,                                                             \
+    };                                                                                             \
+                                                                                                   \
+    static const struct emul_74hc165_config emul_74hc165_config_##n = {                            \
+        .outputs = COND_CODE_1(DT_INST_NODE_HAS_PROP(n, output_gpios),                             \
+                               (emul_74hc165_outputs_##n), (NULL)),                                \
+        .outputs_len = EMUL_74HC165_OUTPUTS_LEN(n),                                                \
+        .rows = EMUL_74HC165_ROWS(n),                                                              \
+        .inputs = DT_INST_PROP(n, inputs),                                                         \
+        .registers = EMUL_74HC165_REGISTERS(n),                                                    \
+    };                                                                                             \
+                                                                                                   \
+    EMUL_DT_INST_DEFINE(n, emul_74hc165_init, &emul_74hc165_data_##n, &emul_74hc165_config_##n,    \
+                        &emul_74hc165_api, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(EMUL_74HC165_INIT)
@@ -8,9 +8,12 @@
 
 #include <zephyr/device.h>
 #include <zephyr/drivers/kscan.h>
+#include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+#include <zmk/kscan_timestamp.h>
+
 #define MATRIX_NODE_ID DT_DRV_INST(0)
 #define MATRIX_ROWS DT_PROP(MATRIX_NODE_ID, rows)
 #define MATRIX_COLS DT_PROP(MATRIX_NODE_ID, columns)
@@ -33,6 +36,7 @@ struct kscan_composite_config {};
 
 struct kscan_composite_data {
     kscan_callback_t callback;
+    zmk_kscan_timestamp_callback_t timestamp_callback;
 
     const struct device *dev;
 };
@@ -55,8 +59,9 @@ static int kscan_composite_disable_callback(const struct device *dev) {
     return 0;
 }
 
-static void kscan_composite_child_callback(const struct device *child_dev, uint32_t row,
-                                           uint32_t column, bool pressed) {
+static void kscan_composite_child_timestamp_callback(const struct device *child_dev, uint32_t row,
+                                                     uint32_t column, bool pressed,
+                                                     int64_t timestamp) {
     // TODO: Ideally we can get this passed into our callback!
     const struct device *dev = DEVICE_DT_GET(DT_DRV_INST(0));
     struct kscan_composite_data *data = dev->data;
@@ -68,7 +73,26 @@ static void kscan_composite_child_callback(const struct device *child_dev, uint3
             continue;
         }
 
-        data->callback(dev, row + cfg->row_offset, column + cfg->column_offset, pressed);
+        zmk_kscan_timestamp_report(dev, data->callback, data->timestamp_callback,
+                                   row + cfg->row_offset, column + cfg->column_offset, pressed,
+                                   timestamp);
+    }
+}
+
+// For children that don't report when their key states were read.
+static void kscan_composite_child_callback(const struct device *child_dev, uint32_t row,
+                                           uint32_t column, bool pressed) {
+    kscan_composite_child_timestamp_callback(child_dev, row, column, pressed, k_uptime_get());
+}
+
+static void kscan_composite_configure_children(void) {
+    for (int i = 0; i < ARRAY_SIZE(kscan_composite_children); i++) {
+        const struct kscan_composite_child_config *cfg = &kscan_composite_children[i];
+
+        if (zmk_kscan_config_timestamp(cfg->child, &kscan_composite_child_timestamp_callback) ==
+            -ENOTSUP) {
+            kscan_config(cfg->child, &kscan_composite_child_callback);
+        }
     }
 }
 
@@ -79,13 +103,25 @@ static int kscan_composite_configure(const struct device *dev, kscan_callback_t
         return -EINVAL;
     }
 
-    for (int i = 0; i < ARRAY_SIZE(kscan_composite_children); i++) {
-        const struct kscan_composite_child_config *cfg = &kscan_composite_children[i];
+    kscan_composite_configure_children();
+
+    data->callback = callback;
+    data->timestamp_callback = NULL;
+
+    return 0;
+}
 
-        kscan_config(cfg->child, &kscan_composite_child_callback);
+static int kscan_composite_configure_timestamp(const struct device *dev,
+                                               zmk_kscan_timestamp_callback_t callback) {
+    struct kscan_composite_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
     }
 
-    data->callback = callback;
+    kscan_composite_configure_children();
+
+    data->timestamp_callback = callback;
 
     return 0;
 }
@@ -110,3 +146,5 @@ static struct kscan_composite_data kscan_composite_data;
 
 DEVICE_DT_INST_DEFINE(0, kscan_composite_init, NULL, &kscan_composite_data, &kscan_composite_config,
                       POST_KERNEL, CONFIG_ZMK_KSCAN_COMPOSITE_INIT_PRIORITY, &mock_driver_api);
+
+ZMK_KSCAN_TIMESTAMP_API_DEFINE(DT_DRV_INST(0), &kscan_composite_configure_timestamp);
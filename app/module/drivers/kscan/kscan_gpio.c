@@ -31,3 +31,18 @@ int kscan_gpio_pin_get(const struct kscan_gpio *gpio, struct kscan_gpio_port_sta
 
     return (state->value & BIT(gpio->spec.pin)) != 0;
 }
+
+int kscan_gpio_switch_output(const struct gpio_dt_spec *prev, const struct gpio_dt_spec *next) {
+    if (prev && next && prev->port == next->port) {
+        return gpio_port_set_masked(next->port, BIT(prev->pin) | BIT(next->pin), BIT(next->pin));
+    }
+
+    if (prev) {
+        int err = gpio_pin_set_dt(prev, 0);
+        if (err) {
+            return err;
+        }
+    }
+
+    return next ? gpio_pin_set_dt(next, 1) : 0;
+}
@@ -59,3 +59,14 @@ void kscan_gpio_list_sort_by_port(struct kscan_gpio_list *list);
  * @retval -EWOULDBLOCK if operation would block.
  */
 int kscan_gpio_pin_get(const struct kscan_gpio *gpio, struct kscan_gpio_port_state *state);
+
+/**
+ * Sets the previous output inactive and the next one active, either of which may be NULL.
+ *
+ * When both are on the same port, this takes a single gpio_port_set_masked() call, which drivers
+ * of external GPIO chips such as zmk,gpio-595 can carry out in a single bus transaction.
+ *
+ * @retval 0 on success.
+ * @retval -errno if setting either pin failed.
+ */
+int kscan_gpio_switch_output(const struct gpio_dt_spec *prev, const struct gpio_dt_spec *next);
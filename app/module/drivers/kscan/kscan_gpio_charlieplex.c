@@ -5,6 +5,7 @@
  */
 
 #include <zmk/debounce.h>
+#include <zmk/kscan_timestamp.h>
 
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
@@ -62,6 +63,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 struct kscan_charlieplex_data {
     const struct device *dev;
     kscan_callback_t callback;
+    zmk_kscan_timestamp_callback_t timestamp_callback;
     struct k_work_delayable work;
     int64_t scan_time; /* Timestamp of the current or scheduled scan. */
     struct gpio_callback irq_callback;
@@ -236,6 +238,7 @@ static void kscan_charlieplex_read_end(const struct device *dev) {
 static int kscan_charlieplex_read(const struct device *dev) {
     struct kscan_charlieplex_data *data = dev->data;
     const struct kscan_charlieplex_config *config = dev->config;
+    const int64_t read_time = k_uptime_get();
     bool continue_scan = false;
 
     // NOTE: RR vs MATRIX: set all pins as input, in case there was a failure on a
@@ -274,7 +277,8 @@ static int kscan_charlieplex_read(const struct device *dev) {
                 const bool pressed = zmk_debounce_is_pressed(state);
 
                 LOG_DBG("Sending event at %i,%i state %s", row, col, pressed ? "on" : "off");
-                data->callback(dev, row, col, pressed);
+                zmk_kscan_timestamp_report(dev, data->callback, data->timestamp_callback, row,
+                                           col, pressed, read_time);
             }
             continue_scan = continue_scan || zmk_debounce_is_active(state);
         }
@@ -313,6 +317,19 @@ static int kscan_charlieplex_configure(const struct device *dev, const kscan_cal
 
     struct kscan_charlieplex_data *data = dev->data;
     data->callback = callback;
+    data->timestamp_callback = NULL;
+    return 0;
+}
+
+static int kscan_charlieplex_configure_timestamp(const struct device *dev,
+                                                 const zmk_kscan_timestamp_callback_t callback) {
+    struct kscan_charlieplex_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->timestamp_callback = callback;
     return 0;
 }
 
@@ -407,6 +424,7 @@ static const struct kscan_driver_api kscan_charlieplex_api = {
             {                                                                                      \
                 .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
                 .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
+                .algorithm = DT_INST_ENUM_IDX(n, debounce_algorithm),                              \
             },                                                                                     \
         .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
         COND_ANY_POLLING((.poll_period_ms = DT_INST_PROP(n, poll_period_ms), ))                    \
@@ -415,6 +433,7 @@ static const struct kscan_driver_api kscan_charlieplex_api = {
                                                                                                    \
     DEVICE_DT_INST_DEFINE(n, &kscan_charlieplex_init, NULL, &kscan_charlieplex_data_##n,           \
                           &kscan_charlieplex_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,  \
-                          &kscan_charlieplex_api);
+                          &kscan_charlieplex_api);                                                 \
+    ZMK_KSCAN_TIMESTAMP_API_DEFINE(DT_DRV_INST(n), &kscan_charlieplex_configure_timestamp);
 
 DT_INST_FOREACH_STATUS_OKAY(KSCAN_CHARLIEPLEX_INIT);
@@ -12,6 +12,9 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
+#include <zmk/gpio_595.h>
+#include <zmk/kscan_timestamp.h>
+
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 // Helper macro
@@ -43,6 +46,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
                                                                                                    \
     struct kscan_gpio_data_##n {                                                                   \
         kscan_callback_t callback;                                                                 \
+        zmk_kscan_timestamp_callback_t timestamp_callback;                                         \
         struct k_timer poll_timer;                                                                 \
         struct CHECK_DEBOUNCE_CFG(n, (k_work), (k_work_delayable)) work;                           \
         bool matrix_state[INST_MATRIX_INPUTS(n)][INST_MATRIX_OUTPUTS(n)];                          \
@@ -70,14 +74,22 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
     static int kscan_gpio_read_##n(const struct device *dev) {                                     \
         bool submit_follow_up_read = false;                                                        \
         struct kscan_gpio_data_##n *data = dev->data;                                              \
+        const int64_t read_time = k_uptime_get();                                                  \
         static bool read_state[INST_MATRIX_INPUTS(n)][INST_MATRIX_OUTPUTS(n)];                     \
         for (int o = 0; o < INST_MATRIX_OUTPUTS(n); o++) {                                         \
+            /* Address pins on a 595 chain are all switched in a single write */                   \
+            for (uint8_t bit = 0; bit < INST_DEMUX_GPIOS(n); bit++) {                              \
+                zmk_gpio_595_defer(kscan_gpio_output_specs_##n(dev)[bit].port);                    \
+            }                                                                                      \
             /* Iterate over bits and set GPIOs accordingly */                                      \
             for (uint8_t bit = 0; bit < INST_DEMUX_GPIOS(n); bit++) {                              \
                 uint8_t state = (o & (0b1 << bit)) >> bit;                                         \
                 const struct gpio_dt_spec *out_spec = &kscan_gpio_output_specs_##n(dev)[bit];      \
                 gpio_pin_set_dt(out_spec, state);                                                  \
             }                                                                                      \
+            for (uint8_t bit = 0; bit < INST_DEMUX_GPIOS(n); bit++) {                              \
+                zmk_gpio_595_flush(kscan_gpio_output_specs_##n(dev)[bit].port);                    \
+            }                                                                                      \
             /* Let the col settle before reading the rows */                                       \
             k_usleep(1);                                                                           \
                                                                                                    \
@@ -94,7 +106,8 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
                 if (pressed != data->matrix_state[r][c]) {                                         \
                     LOG_DBG("Sending event at %d,%d state %s", r, c, (pressed ? "on" : "off"));    \
                     data->matrix_state[r][c] = pressed;                                            \
-                    data->callback(dev, r, c, pressed);                                            \
+                    zmk_kscan_timestamp_report(dev, data->callback, data->timestamp_callback, r,   \
+                                               c, pressed, read_time);                             \
                 }                                                                                  \
             }                                                                                      \
         }                                                                                          \
@@ -121,10 +134,21 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
             return -EINVAL;                                                                        \
         }                                                                                          \
         data->callback = callback;                                                                 \
+        data->timestamp_callback = NULL;                                                           \
         LOG_DBG("Configured GPIO %d", n);                                                          \
         return 0;                                                                                  \
     };                                                                                             \
                                                                                                    \
+    static int kscan_gpio_configure_timestamp_##n(const struct device *dev,                        \
+                                                  zmk_kscan_timestamp_callback_t callback) {       \
+        struct kscan_gpio_data_##n *data = dev->data;                                              \
+        if (!callback) {                                                                           \
+            return -EINVAL;                                                                        \
+        }                                                                                          \
+        data->timestamp_callback = callback;                                                       \
+        return 0;                                                                                  \
+    }                                                                                              \
+                                                                                                   \
     /* KSCAN API enable function */                                                                \
     static int kscan_gpio_enable_##n(const struct device *dev) {                                   \
         LOG_DBG("KSCAN API enable");                                                               \
@@ -204,6 +228,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
                                                                                                    \
     DEVICE_DT_INST_DEFINE(n, kscan_gpio_init_##n, NULL, &kscan_gpio_data_##n,                      \
                           &kscan_gpio_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,         \
-                          &gpio_driver_api_##n);
+                          &gpio_driver_api_##n);                                                   \
+    ZMK_KSCAN_TIMESTAMP_API_DEFINE(DT_DRV_INST(n), &kscan_gpio_configure_timestamp_##n);
 
 DT_INST_FOREACH_STATUS_OKAY(GPIO_INST_INIT)
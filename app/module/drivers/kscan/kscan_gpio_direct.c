@@ -15,6 +15,7 @@
 #include <zephyr/sys/util.h>
 
 #include <zmk/debounce.h>
+#include <zmk/kscan_timestamp.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
@@ -54,6 +55,7 @@ struct kscan_direct_data {
     const struct device *dev;
     struct kscan_gpio_list inputs;
     kscan_callback_t callback;
+    zmk_kscan_timestamp_callback_t timestamp_callback;
     struct k_work_delayable work;
 #if USE_INTERRUPTS
     /** Array of length config->inputs.len */
@@ -170,6 +172,7 @@ static void kscan_direct_read_end(const struct device *dev) {
 static int kscan_direct_read(const struct device *dev) {
     struct kscan_direct_data *data = dev->data;
     const struct kscan_direct_config *config = dev->config;
+    const int64_t read_time = k_uptime_get();
 
     // Read the inputs.
     struct kscan_gpio_port_state state = {0};
@@ -198,7 +201,8 @@ static int kscan_direct_read(const struct device *dev) {
             const bool pressed = zmk_debounce_is_pressed(deb_state);
 
             LOG_DBG("Sending event at 0,%i state %s", gpio->index, pressed ? "on" : "off");
-            data->callback(dev, 0, gpio->index, pressed);
+            zmk_kscan_timestamp_report(dev, data->callback, data->timestamp_callback, 0,
+                                       gpio->index, pressed, read_time);
             if (config->toggle_mode && pressed) {
                 kscan_inputs_set_flags(&data->inputs, &gpio->spec);
             }
@@ -233,6 +237,19 @@ static int kscan_direct_configure(const struct device *dev, kscan_callback_t cal
     }
 
     data->callback = callback;
+    data->timestamp_callback = NULL;
+    return 0;
+}
+
+static int kscan_direct_configure_timestamp(const struct device *dev,
+                                            const zmk_kscan_timestamp_callback_t callback) {
+    struct kscan_direct_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->timestamp_callback = callback;
     return 0;
 }
 
@@ -348,6 +365,7 @@ static const struct kscan_driver_api kscan_direct_api = {
             {                                                                                      \
                 .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
                 .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
+                .algorithm = DT_INST_ENUM_IDX(n, debounce_algorithm),                              \
             },                                                                                     \
         .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
         .poll_period_ms = DT_INST_PROP(n, poll_period_ms),                                         \
@@ -356,6 +374,7 @@ static const struct kscan_driver_api kscan_direct_api = {
                                                                                                    \
     DEVICE_DT_INST_DEFINE(n, &kscan_direct_init, NULL, &kscan_direct_data_##n,                     \
                           &kscan_direct_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,       \
-                          &kscan_direct_api);
+                          &kscan_direct_api);                                                      \
+    ZMK_KSCAN_TIMESTAMP_API_DEFINE(DT_DRV_INST(n), &kscan_direct_configure_timestamp);
 
 DT_INST_FOREACH_STATUS_OKAY(KSCAN_DIRECT_INIT);
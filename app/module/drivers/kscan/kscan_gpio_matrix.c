@@ -13,9 +13,12 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/__assert.h>
+#include <zephyr/sys/math_extras.h>
 #include <zephyr/sys/util.h>
+#include <string.h>
 
 #include <zmk/debounce.h>
+#include <zmk/kscan_timestamp.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
@@ -28,7 +31,9 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #define INST_ROWS_LEN(n) DT_INST_PROP_LEN(n, row_gpios)
 #define INST_COLS_LEN(n) DT_INST_PROP_LEN(n, col_gpios)
 #define INST_MATRIX_LEN(n) (INST_ROWS_LEN(n) * INST_COLS_LEN(n))
+#define INST_MATRIX_WORDS(n) DIV_ROUND_UP(INST_MATRIX_LEN(n), DEBOUNCE_PACKED_WIDTH)
 #define INST_INPUTS_LEN(n) COND_DIODE_DIR(n, (INST_COLS_LEN(n)), (INST_ROWS_LEN(n)))
+#define INST_OUTPUTS_LEN(n) COND_DIODE_DIR(n, (INST_ROWS_LEN(n)), (INST_COLS_LEN(n)))
 
 #if CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS >= 0
 #define INST_DEBOUNCE_PRESS_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS
@@ -66,10 +71,22 @@ struct kscan_matrix_irq_callback {
     struct gpio_callback callback;
 };
 
+/** A set of pins on one GPIO port, so they can be driven with a single call. */
+struct kscan_matrix_port_pins {
+    const struct device *port;
+    gpio_port_pins_t pins;
+};
+
 struct kscan_matrix_data {
     const struct device *dev;
     struct kscan_gpio_list inputs;
+    /** Output pins grouped by port. Array of length config->outputs.len */
+    struct kscan_matrix_port_pins *output_ports;
+    size_t output_ports_len;
+    /** Output left active by the last scan, or NULL. */
+    const struct gpio_dt_spec *active_output;
     kscan_callback_t callback;
+    zmk_kscan_timestamp_callback_t timestamp_callback;
     struct k_work_delayable work;
 #if USE_INTERRUPTS
     /** Array of length config->inputs.len */
@@ -78,10 +95,12 @@ struct kscan_matrix_data {
     /** Timestamp of the current or scheduled scan. */
     int64_t scan_time;
     /**
-     * Current state of the matrix as a flattened 2D array of length
-     * (config->rows * config->cols)
+     * Current state of the matrix as a flattened 2D bit array, packed DEBOUNCE_PACKED_WIDTH keys
+     * to an element. Array of length config->matrix_words
      */
-    struct zmk_debounce_state *matrix_state;
+    struct zmk_debounce_packed_state *matrix_state;
+    /** Keys read as pressed in the current scan, laid out the same as matrix_state. */
+    uint32_t *matrix_active;
 };
 
 struct kscan_matrix_config {
@@ -89,23 +108,24 @@ struct kscan_matrix_config {
     struct zmk_debounce_config debounce_config;
     size_t rows;
     size_t cols;
+    size_t matrix_words;
     int32_t debounce_scan_period_ms;
     int32_t poll_period_ms;
     enum kscan_diode_direction diode_direction;
 };
 
 /**
- * Get the index into a matrix state array from a row and column.
+ * Get the bit index into a matrix state array from a row and column.
  */
 static int state_index_rc(const struct kscan_matrix_config *config, const int row, const int col) {
     __ASSERT(row < config->rows, "Invalid row %i", row);
     __ASSERT(col < config->cols, "Invalid column %i", col);
 
-    return (col * config->rows) + row;
+    return (row * config->cols) + col;
 }
 
 /**
- * Get the index into a matrix state array from input/output pin indices.
+ * Get the bit index into a matrix state array from input/output pin indices.
  */
 static int state_index_io(const struct kscan_matrix_config *config, const int input_idx,
                           const int output_idx) {
@@ -115,14 +135,14 @@ static int state_index_io(const struct kscan_matrix_config *config, const int in
 }
 
 static int kscan_matrix_set_all_outputs(const struct device *dev, const int value) {
-    const struct kscan_matrix_config *config = dev->config;
+    const struct kscan_matrix_data *data = dev->data;
 
-    for (int i = 0; i < config->outputs.len; i++) {
-        const struct gpio_dt_spec *gpio = &config->outputs.gpios[i].spec;
+    for (int i = 0; i < data->output_ports_len; i++) {
+        const struct kscan_matrix_port_pins *port = &data->output_ports[i];
 
-        int err = gpio_pin_set_dt(gpio, value);
+        int err = gpio_port_set_masked(port->port, port->pins, value ? port->pins : 0);
         if (err) {
-            LOG_ERR("Failed to set output %i to %i: %i", i, value, err);
+            LOG_ERR("Failed to set outputs on %s to %i: %i", port->port->name, value, err);
             return err;
         }
     }
@@ -150,19 +170,24 @@ static int kscan_matrix_interrupt_configure(const struct device *dev, const gpio
 
 #if USE_INTERRUPTS
 static int kscan_matrix_interrupt_enable(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
+
     int err = kscan_matrix_interrupt_configure(dev, GPIO_INT_LEVEL_ACTIVE);
     if (err) {
         return err;
     }
 
     // While interrupts are enabled, set all outputs active so a pressed key
-    // will trigger an interrupt.
+    // will trigger an interrupt. This also covers the output left active by the last scan.
+    data->active_output = NULL;
     return kscan_matrix_set_all_outputs(dev, 1);
 }
 #endif
 
 #if USE_INTERRUPTS
 static int kscan_matrix_interrupt_disable(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
+
     int err = kscan_matrix_interrupt_configure(dev, GPIO_INT_DISABLE);
     if (err) {
         return err;
@@ -170,6 +195,7 @@ static int kscan_matrix_interrupt_disable(const struct device *dev) {
 
     // While interrupts are disabled, set all outputs inactive so
     // kscan_matrix_read() can scan them one by one.
+    data->active_output = NULL;
     return kscan_matrix_set_all_outputs(dev, 0);
 }
 #endif
@@ -207,6 +233,13 @@ static void kscan_matrix_read_end(const struct device *dev) {
     struct kscan_matrix_data *data = dev->data;
     const struct kscan_matrix_config *config = dev->config;
 
+    int err = kscan_gpio_switch_output(data->active_output, NULL);
+    if (err) {
+        LOG_ERR("Failed to set last output inactive: %i", err);
+    } else {
+        data->active_output = NULL;
+    }
+
     data->scan_time += config->poll_period_ms;
 
     // Return to polling slowly.
@@ -217,17 +250,23 @@ static void kscan_matrix_read_end(const struct device *dev) {
 static int kscan_matrix_read(const struct device *dev) {
     struct kscan_matrix_data *data = dev->data;
     const struct kscan_matrix_config *config = dev->config;
+    const int64_t read_time = k_uptime_get();
+
+    memset(data->matrix_active, 0, config->matrix_words * sizeof(data->matrix_active[0]));
 
-    // Scan the matrix.
+    // Scan the matrix. Outputs are sorted by port, so moving on to the next one usually only
+    // takes one call. That includes switching off the output left active by the last scan.
     for (int i = 0; i < config->outputs.len; i++) {
         const struct kscan_gpio *out_gpio = &config->outputs.gpios[i];
 
-        int err = gpio_pin_set_dt(&out_gpio->spec, 1);
+        int err = kscan_gpio_switch_output(data->active_output, &out_gpio->spec);
         if (err) {
             LOG_ERR("Failed to set output %i active: %i", out_gpio->index, err);
             return err;
         }
 
+        data->active_output = &out_gpio->spec;
+
 #if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BEFORE_INPUTS > 0
         k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BEFORE_INPUTS);
 #endif
@@ -243,43 +282,56 @@ static int kscan_matrix_read(const struct device *dev) {
                 return active;
             }
 
-            zmk_debounce_update(&data->matrix_state[index], active, config->debounce_scan_period_ms,
-                                &config->debounce_config);
+            if (active) {
+                data->matrix_active[index / DEBOUNCE_PACKED_WIDTH] |=
+                    BIT(index % DEBOUNCE_PACKED_WIDTH);
+            }
         }
 
-        err = gpio_pin_set_dt(&out_gpio->spec, 0);
+#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS > 0
+        // The output needs time to settle after going inactive, so it can't be switched off
+        // together with setting the next one active.
+        err = kscan_gpio_switch_output(data->active_output, NULL);
         if (err) {
             LOG_ERR("Failed to set output %i inactive: %i", out_gpio->index, err);
             return err;
         }
 
-#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS > 0
+        data->active_output = NULL;
         k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS);
 #endif
     }
 
     // Process the new state.
-    bool continue_scan = false;
-
-    for (int r = 0; r < config->rows; r++) {
-        for (int c = 0; c < config->cols; c++) {
-            const int index = state_index_rc(config, r, c);
-            struct zmk_debounce_state *state = &data->matrix_state[index];
-
-            if (zmk_debounce_get_changed(state)) {
-                const bool pressed = zmk_debounce_is_pressed(state);
-
-                LOG_DBG("Sending event at %i,%i state %s", r, c, pressed ? "on" : "off");
-                data->callback(dev, r, c, pressed);
-            }
-
-            continue_scan = continue_scan || zmk_debounce_is_active(state);
+    uint32_t continue_scan = 0;
+
+    for (int i = 0; i < config->matrix_words; i++) {
+        struct zmk_debounce_packed_state *state = &data->matrix_state[i];
+        uint32_t changed =
+            zmk_debounce_packed_update(state, data->matrix_active[i],
+                                       config->debounce_scan_period_ms, &config->debounce_config);
+        const uint32_t pressed = zmk_debounce_packed_get_pressed(state);
+
+        while (changed) {
+            const int bit = u32_count_trailing_zeros(changed);
+            const int index = i * DEBOUNCE_PACKED_WIDTH + bit;
+            const int r = index / config->cols;
+            const int c = index % config->cols;
+
+            changed &= changed - 1;
+
+            LOG_DBG("Sending event at %i,%i state %s", r, c, (pressed & BIT(bit)) ? "on" : "off");
+            zmk_kscan_timestamp_report(dev, data->callback, data->timestamp_callback, r, c,
+                                       pressed & BIT(bit), read_time);
         }
+
+        continue_scan |= zmk_debounce_packed_get_active(state);
     }
 
     if (continue_scan) {
         // At least one key is pressed or the debouncer has not yet decided if
-        // it is pressed. Poll quickly until everything is released.
+        // it is pressed. Poll quickly until everything is released. The last
+        // output stays active until the next scan switches to the first one.
         kscan_matrix_read_continue(dev);
     } else {
         // All keys are released. Return to normal.
@@ -303,6 +355,19 @@ static int kscan_matrix_configure(const struct device *dev, const kscan_callback
     }
 
     data->callback = callback;
+    data->timestamp_callback = NULL;
+    return 0;
+}
+
+static int kscan_matrix_configure_timestamp(const struct device *dev,
+                                            const zmk_kscan_timestamp_callback_t callback) {
+    struct kscan_matrix_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->timestamp_callback = callback;
     return 0;
 }
 
@@ -323,6 +388,12 @@ static int kscan_matrix_disable(const struct device *dev) {
 #if USE_INTERRUPTS
     return kscan_matrix_interrupt_disable(dev);
 #else
+    int err = kscan_gpio_switch_output(data->active_output, NULL);
+    if (err) {
+        return err;
+    }
+
+    data->active_output = NULL;
     return 0;
 #endif
 }
@@ -404,6 +475,30 @@ static int kscan_matrix_init_outputs(const struct device *dev) {
     return 0;
 }
 
+static void kscan_matrix_init_output_ports(const struct device *dev) {
+    const struct kscan_matrix_config *config = dev->config;
+    struct kscan_matrix_data *data = dev->data;
+    struct kscan_gpio_list outputs = config->outputs;
+
+    // Sort outputs by port so pins of the same port end up next to each other, both here and
+    // when scanning.
+    kscan_gpio_list_sort_by_port(&outputs);
+
+    data->output_ports_len = 0;
+
+    for (int i = 0; i < outputs.len; i++) {
+        const struct gpio_dt_spec *gpio = &outputs.gpios[i].spec;
+
+        if (data->output_ports_len == 0 ||
+            data->output_ports[data->output_ports_len - 1].port != gpio->port) {
+            data->output_ports[data->output_ports_len++] =
+                (struct kscan_matrix_port_pins){.port = gpio->port};
+        }
+
+        data->output_ports[data->output_ports_len - 1].pins |= BIT(gpio->pin);
+    }
+}
+
 static int kscan_matrix_init(const struct device *dev) {
     struct kscan_matrix_data *data = dev->data;
 
@@ -414,6 +509,7 @@ static int kscan_matrix_init(const struct device *dev) {
 
     kscan_matrix_init_inputs(dev);
     kscan_matrix_init_outputs(dev);
+    kscan_matrix_init_output_ports(dev);
     kscan_matrix_set_all_outputs(dev, 0);
 
     k_work_init_delayable(&data->work, kscan_matrix_work_handler);
@@ -439,7 +535,10 @@ static const struct kscan_driver_api kscan_matrix_api = {
     static struct kscan_gpio kscan_matrix_cols_##n[] = {                                           \
         LISTIFY(INST_COLS_LEN(n), KSCAN_GPIO_COL_CFG_INIT, (, ), n)};                              \
                                                                                                    \
-    static struct zmk_debounce_state kscan_matrix_state_##n[INST_MATRIX_LEN(n)];                   \
+    static struct zmk_debounce_packed_state kscan_matrix_state_##n[INST_MATRIX_WORDS(n)];          \
+    static uint32_t kscan_matrix_active_##n[INST_MATRIX_WORDS(n)];                                 \
+                                                                                                   \
+    static struct kscan_matrix_port_pins kscan_matrix_output_ports_##n[INST_OUTPUTS_LEN(n)];       \
                                                                                                    \
     COND_INTERRUPTS(                                                                               \
         (static struct kscan_matrix_irq_callback kscan_matrix_irqs_##n[INST_INPUTS_LEN(n)];))      \
@@ -448,17 +547,21 @@ static const struct kscan_driver_api kscan_matrix_api = {
         .inputs =                                                                                  \
             KSCAN_GPIO_LIST(COND_DIODE_DIR(n, (kscan_matrix_cols_##n), (kscan_matrix_rows_##n))),  \
         .matrix_state = kscan_matrix_state_##n,                                                    \
+        .matrix_active = kscan_matrix_active_##n,                                                  \
+        .output_ports = kscan_matrix_output_ports_##n,                                             \
         COND_INTERRUPTS((.irqs = kscan_matrix_irqs_##n, ))};                                       \
                                                                                                    \
     static struct kscan_matrix_config kscan_matrix_config_##n = {                                  \
         .rows = ARRAY_SIZE(kscan_matrix_rows_##n),                                                 \
         .cols = ARRAY_SIZE(kscan_matrix_cols_##n),                                                 \
+        .matrix_words = INST_MATRIX_WORDS(n),                                                      \
         .outputs =                                                                                 \
             KSCAN_GPIO_LIST(COND_DIODE_DIR(n, (kscan_matrix_rows_##n), (kscan_matrix_cols_##n))),  \
         .debounce_config =                                                                         \
             {                                                                                      \
                 .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
                 .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
+                .algorithm = DT_INST_ENUM_IDX(n, debounce_algorithm),                              \
             },                                                                                     \
         .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
         .poll_period_ms = DT_INST_PROP(n, poll_period_ms),                                         \
@@ -467,6 +570,7 @@ static const struct kscan_driver_api kscan_matrix_api = {
                                                                                                    \
     DEVICE_DT_INST_DEFINE(n, &kscan_matrix_init, NULL, &kscan_matrix_data_##n,                     \
                           &kscan_matrix_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,       \
-                          &kscan_matrix_api);
+                          &kscan_matrix_api);                                                      \
+    ZMK_KSCAN_TIMESTAMP_API_DEFINE(DT_DRV_INST(n), &kscan_matrix_configure_timestamp);
 
 DT_INST_FOREACH_STATUS_OKAY(KSCAN_MATRIX_INIT);
@@ -48,6 +48,7 @@ static int kscan_mock_configure(const struct device *dev, kscan_callback_t callb
     struct kscan_mock_config_##n {                                                                 \
         uint32_t events[DT_INST_PROP_LEN(n, events)];                                              \
         bool exit_after;                                                                           \
+        bool zero_delay_same_scan;                                                                 \
     };                                                                                             \
     static void kscan_mock_schedule_next_event_##n(const struct device *dev) {                     \
         struct kscan_mock_data *data = dev->data;                                                  \
@@ -69,6 +70,14 @@ static int kscan_mock_configure(const struct device *dev, kscan_callback_t callb
         LOG_DBG("ev %u row %d column %d state %d\n", ev, ZMK_MOCK_ROW(ev), ZMK_MOCK_COL(ev),       \
                 ZMK_MOCK_IS_PRESS(ev));                                                            \
         data->callback(data->dev, ZMK_MOCK_ROW(ev), ZMK_MOCK_COL(ev), ZMK_MOCK_IS_PRESS(ev));      \
+        while (cfg->zero_delay_same_scan && ZMK_MOCK_MSEC(ev) == 0 &&                              \
+               data->event_index + 1 < DT_INST_PROP_LEN(n, events)) {                              \
+            ev = cfg->events[++data->event_index];                                                 \
+            LOG_DBG("ev %u row %d column %d state %d\n", ev, ZMK_MOCK_ROW(ev), ZMK_MOCK_COL(ev),   \
+                    ZMK_MOCK_IS_PRESS(ev));                                                        \
+            data->callback(data->dev, ZMK_MOCK_ROW(ev), ZMK_MOCK_COL(ev),                          \
+                           ZMK_MOCK_IS_PRESS(ev));                                                 \
+        }                                                                                          \
         kscan_mock_schedule_next_event_##n(data->dev);                                             \
         data->event_index++;                                                                       \
     }                                                                                              \
@@ -89,7 +98,9 @@ static int kscan_mock_configure(const struct device *dev, kscan_callback_t callb
     };                                                                                             \
     static struct kscan_mock_data kscan_mock_data_##n;                                             \
     static const struct kscan_mock_config_##n kscan_mock_config_##n = {                            \
-        .events = DT_INST_PROP(n, events), .exit_after = DT_INST_PROP(n, exit_after)};             \
+        .events = DT_INST_PROP(n, events),                                                         \
+        .exit_after = DT_INST_PROP(n, exit_after),                                                 \
+        .zero_delay_same_scan = DT_INST_PROP(n, zero_delay_same_scan)};                            \
     DEVICE_DT_INST_DEFINE(n, kscan_mock_init_##n, NULL, &kscan_mock_data_##n,                      \
                           &kscan_mock_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,         \
                           &mock_driver_api_##n);
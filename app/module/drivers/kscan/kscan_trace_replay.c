@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_kscan_trace_replay
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "cmdline.h"
+#include "soc.h"
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/kscan_trace.h>
+
+BUILD_ASSERT(DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT) <= 1,
+             "Only one zmk,kscan-trace-replay node may be enabled");
+
+#define SPEED_UNSET UINT32_MAX
+
+struct kscan_trace_replay_data {
+    kscan_callback_t callback;
+    struct k_work_delayable work;
+    const struct device *dev;
+    FILE *file;
+    struct zmk_kscan_trace_record next;
+    bool done;
+    uint32_t speed;
+    uint32_t events;
+    /** Trace time of the next event. */
+    int64_t trace_ms;
+    /** Uptime and process CPU time at which the replay started. */
+    int64_t start_ms;
+    struct timespec start_cpu;
+};
+
+struct kscan_trace_replay_config {
+    const char *file;
+    uint32_t speed;
+    bool exit_after;
+};
+
+static char *file_option;
+static uint32_t speed_option = SPEED_UNSET;
+
+static void kscan_trace_replay_options(void) {
+    static struct args_struct_t options[] = {
+        {.option = "kscan-trace",
+         .name = "path",
+         .type = 's',
+         .dest = (void *)&file_option,
+         .descript = "KSCAN trace to replay, instead of the file set in the devicetree"},
+        {.option = "kscan-trace-speed",
+         .name = "speed",
+         .type = 'u',
+         .dest = (void *)&speed_option,
+         .descript = "How many times faster than recorded to replay the KSCAN trace, or 0 to "
+                     "replay it as fast as possible"},
+        ARG_TABLE_ENDMARKER,
+    };
+
+    native_add_command_line_opts(options);
+}
+
+NATIVE_TASK(kscan_trace_replay_options, PRE_BOOT_1, 1);
+
+// Reads up to the next event record, adding the delays on the way to the trace time.
+static bool kscan_trace_replay_read_next(struct kscan_trace_replay_data *data) {
+    struct zmk_kscan_trace_record record;
+
+    while (fread(&record, sizeof(record), 1, data->file) == 1) {
+        data->trace_ms += sys_le16_to_cpu(record.delay_ms);
+
+        if (record.row == ZMK_KSCAN_TRACE_DELAY_ROW) {
+            data->trace_ms += (int64_t)record.column << 16;
+            continue;
+        }
+
+        data->next = record;
+        return true;
+    }
+
+    return false;
+}
+
+static void kscan_trace_replay_schedule_next(const struct device *dev) {
+    struct kscan_trace_replay_data *data = dev->data;
+
+    if (!kscan_trace_replay_read_next(data)) {
+        // Finish up once the events already reported have been processed.
+        data->done = true;
+        k_work_schedule(&data->work, K_NO_WAIT);
+        return;
+    }
+
+    if (data->speed == 0) {
+        k_work_schedule(&data->work, K_NO_WAIT);
+        return;
+    }
+
+    int64_t deliver_at = data->start_ms + (data->trace_ms / data->speed);
+
+    k_work_schedule(&data->work, K_TIMEOUT_ABS_MS(deliver_at));
+}
+
+static void kscan_trace_replay_finish(const struct device *dev) {
+    const struct kscan_trace_replay_config *config = dev->config;
+    struct kscan_trace_replay_data *data = dev->data;
+    struct timespec end_cpu;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end_cpu);
+
+    int64_t cpu_us = (end_cpu.tv_sec - data->start_cpu.tv_sec) * USEC_PER_SEC +
+                     (end_cpu.tv_nsec - data->start_cpu.tv_nsec) / NSEC_PER_USEC;
+
+    LOG_INF("Replayed %d events spanning %lld ms in %lld ms, using %lld us of CPU time",
+            data->events, data->trace_ms, k_uptime_get() - data->start_ms, cpu_us);
+
+    fclose(data->file);
+    data->file = NULL;
+
+    if (config->exit_after) {
+        LOG_DBG("Exiting");
+        exit(0);
+    }
+}
+
+static void kscan_trace_replay_work_handler(struct k_work *work) {
+    struct k_work_delayable *d_work = k_work_delayable_from_work(work);
+    struct kscan_trace_replay_data *data =
+        CONTAINER_OF(d_work, struct kscan_trace_replay_data, work);
+
+    if (data->done) {
+        kscan_trace_replay_finish(data->dev);
+        return;
+    }
+
+    uint32_t row = data->next.row;
+    uint32_t column = data->next.column & ZMK_KSCAN_TRACE_COLUMN_MASK;
+    bool pressed = data->next.column & ZMK_KSCAN_TRACE_PRESSED;
+
+    LOG_DBG("Replaying row %d column %d state %d at %lld ms", row, column, pressed,
+            data->trace_ms);
+
+    data->events++;
+    data->callback(data->dev, row, column, pressed);
+
+    kscan_trace_replay_schedule_next(data->dev);
+}
+
+static int kscan_trace_replay_configure(const struct device *dev, kscan_callback_t callback) {
+    struct kscan_trace_replay_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->callback = callback;
+
+    return 0;
+}
+
+static int kscan_trace_replay_enable_callback(const struct device *dev) {
+    const struct kscan_trace_replay_config *config = dev->config;
+    struct kscan_trace_replay_data *data = dev->data;
+    const char *path = file_option ? file_option : config->file;
+    uint8_t header[ZMK_KSCAN_TRACE_HEADER_LEN];
+
+    if (data->file) {
+        return 0;
+    }
+
+    data->file = fopen(path, "rb");
+    if (!data->file) {
+        LOG_ERR("Failed to open KSCAN trace %s", path);
+        return -ENOENT;
+    }
+
+    if (fread(header, sizeof(header), 1, data->file) != 1 ||
+        memcmp(header, ZMK_KSCAN_TRACE_MAGIC, sizeof(header) - 1) != 0 ||
+        header[sizeof(header) - 1] != ZMK_KSCAN_TRACE_VERSION) {
+        LOG_ERR("%s is not a version %d KSCAN trace", path, ZMK_KSCAN_TRACE_VERSION);
+        fclose(data->file);
+        data->file = NULL;
+        return -EINVAL;
+    }
+
+    data->speed = speed_option != SPEED_UNSET ? speed_option : config->speed;
+    data->done = false;
+    data->events = 0;
+    data->trace_ms = 0;
+    data->start_ms = k_uptime_get();
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &data->start_cpu);
+
+    kscan_trace_replay_schedule_next(dev);
+
+    return 0;
+}
+
+static int kscan_trace_replay_disable_callback(const struct device *dev) {
+    struct kscan_trace_replay_data *data = dev->data;
+
+    k_work_cancel_delayable(&data->work);
+
+    return 0;
+}
+
+static int kscan_trace_replay_init(const struct device *dev) {
+    struct kscan_trace_replay_data *data = dev->data;
+
+    data->dev = dev;
+    k_work_init_delayable(&data->work, kscan_trace_replay_work_handler);
+
+    return 0;
+}
+
+static const struct kscan_driver_api kscan_trace_replay_api = {
+    .config = kscan_trace_replay_configure,
+    .enable_callback = kscan_trace_replay_enable_callback,
+    .disable_callback = kscan_trace_replay_disable_callback,
+};
+
+#define KSCAN_TRACE_REPLAY_INIT(n)                                                                 \
+    static struct kscan_trace_replay_data kscan_trace_replay_data_##n;                             \
+                                                                                                   \
+    static const struct kscan_trace_replay_config kscan_trace_replay_config_##n = {                \
+        .file = DT_INST_PROP_OR(n, file, ""),                                                      \
+        .speed = DT_INST_PROP(n, speed),                                                           \
+        .exit_after = DT_INST_PROP(n, exit_after),                                                 \
+    };                                                                                             \
+                                                                                                   \
+    DEVICE_DT_INST_DEFINE(n, kscan_trace_replay_init, NULL, &kscan_trace_replay_data_##n,          \
+                          &kscan_trace_replay_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY, \
+                          &kscan_trace_replay_api);
+
+DT_INST_FOREACH_STATUS_OKAY(KSCAN_TRACE_REPLAY_INIT)
@@ -10,20 +10,41 @@
 #include <stdint.h>
 #include <zephyr/sys/util.h>
 
-#define DEBOUNCE_COUNTER_BITS 14
+#define DEBOUNCE_COUNTER_BITS 13
 #define DEBOUNCE_COUNTER_MAX BIT_MASK(DEBOUNCE_COUNTER_BITS)
 
 struct zmk_debounce_state {
     bool pressed : 1;
     bool changed : 1;
+    /** Set while the switch is ignored after an eager change. The counter holds the time left. */
+    bool locked : 1;
     uint16_t counter : DEBOUNCE_COUNTER_BITS;
 };
 
+enum zmk_debounce_algorithm {
+    /**
+     * Latches a change once the switch has spent the press or release time more in the new
+     * state than in the old one. Adds that time to every change.
+     */
+    ZMK_DEBOUNCE_INTEGRATOR,
+    /**
+     * Latches a press as soon as it is seen, then ignores the switch for the press time. Latches a
+     * release once the switch has been released for the release time without interruption.
+     */
+    ZMK_DEBOUNCE_EAGER_PRESS,
+    /**
+     * Latches any change as soon as it is seen, then ignores the switch for the press or release
+     * time respectively.
+     */
+    ZMK_DEBOUNCE_EAGER,
+};
+
 struct zmk_debounce_config {
-    /** Duration a switch must be pressed to latch as pressed. */
+    /** Duration a switch must be pressed to latch as pressed, or is ignored after a press. */
     uint32_t debounce_press_ms;
-    /** Duration a switch must be released to latch as released. */
+    /** Duration a switch must be released to latch as released, or is ignored after a release. */
     uint32_t debounce_release_ms;
+    enum zmk_debounce_algorithm algorithm;
 };
 
 /**
@@ -38,9 +59,9 @@ void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, co
                          const struct zmk_debounce_config *config);
 
 /**
- * @returns whether the switch is either latched as pressed or it is potentially
- * pressed but the debouncer has not yet made a decision. If this returns true,
- * the kscan driver should continue to poll quickly.
+ * @returns whether the switch is either latched as pressed, potentially pressed
+ * but the debouncer has not yet made a decision, or ignored after a change. If
+ * this returns true, the kscan driver should continue to poll quickly.
  */
 bool zmk_debounce_is_active(const struct zmk_debounce_state *state);
 
@@ -54,3 +75,40 @@ bool zmk_debounce_is_pressed(const struct zmk_debounce_state *state);
  * debounce_update.
  */
 bool zmk_debounce_get_changed(const struct zmk_debounce_state *state);
+
+/** Number of switches debounced together by zmk_debounce_packed_update(). */
+#define DEBOUNCE_PACKED_WIDTH 32
+
+/**
+ * Debounce state for up to 32 switches, stored bit-sliced so they are all updated with a few
+ * bitwise operations. Bit n of each field belongs to switch n. The counters are kept in scan
+ * periods rather than milliseconds, with counter[b] holding bit b of each switch's counter.
+ */
+struct zmk_debounce_packed_state {
+    uint32_t pressed;
+    uint32_t locked;
+    uint32_t counter[DEBOUNCE_COUNTER_BITS];
+};
+
+/**
+ * Debounces up to 32 switches at once, the same as calling zmk_debounce_update() for each of
+ * them. Since the counters count scans, elapsed_ms must be the same on every call.
+ *
+ * @param state The state for the switches to debounce.
+ * @param active Mask of the switches that are currently pressed.
+ * @param elapsed_ms Time elapsed since the previous update in milliseconds.
+ * @param config Debounce settings.
+ * @returns the mask of switches whose pressed state changed.
+ */
+uint32_t zmk_debounce_packed_update(struct zmk_debounce_packed_state *state, const uint32_t active,
+                                    const int elapsed_ms, const struct zmk_debounce_config *config);
+
+/**
+ * @returns the mask of switches for which zmk_debounce_is_active() would return true.
+ */
+uint32_t zmk_debounce_packed_get_active(const struct zmk_debounce_packed_state *state);
+
+/**
+ * @returns the mask of switches latched as pressed.
+ */
+uint32_t zmk_debounce_packed_get_pressed(const struct zmk_debounce_packed_state *state);
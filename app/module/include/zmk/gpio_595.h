@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <zephyr/device.h>
+
+/**
+ * Batching of writes to a zmk,gpio-595 shift register chain.
+ *
+ * The driver keeps a shadow of the output registers. Setting pins normally updates the shadow and
+ * writes it out immediately, skipping the write if nothing changed. Pins set from an ISR are
+ * written out from the system work queue, together with any other changes made before then.
+ *
+ * Both functions can be called on any GPIO device, so a KSCAN driver can batch the writes to its
+ * outputs without knowing which controller they are on.
+ */
+
+#if IS_ENABLED(CONFIG_GPIO_595)
+
+/**
+ * Defers writes to a 595 chain. Until zmk_gpio_595_flush() is called, setting its pins only
+ * updates the shadow of its registers.
+ *
+ * This applies to every user of the chain, so only defer writes on chains whose pins are all
+ * driven by the caller. Pins set from an ISR in the meantime are held back as well.
+ *
+ * @param dev The zmk,gpio-595 device.
+ * @retval 0 on success.
+ * @retval -ENOTSUP if dev isn't a zmk,gpio-595 device.
+ */
+int zmk_gpio_595_defer(const struct device *dev);
+
+/**
+ * Writes all changes made since writes were deferred in a single SPI transaction, then goes back
+ * to writing changes immediately.
+ *
+ * @param dev The zmk,gpio-595 device.
+ * @retval 0 on success.
+ * @retval -ENOTSUP if dev isn't a zmk,gpio-595 device.
+ * @retval -EWOULDBLOCK if called from an ISR.
+ * @retval -errno if the SPI write failed.
+ */
+int zmk_gpio_595_flush(const struct device *dev);
+
+#else
+
+static inline int zmk_gpio_595_defer(const struct device *dev) { return -ENOTSUP; }
+
+static inline int zmk_gpio_595_flush(const struct device *dev) { return -ENOTSUP; }
+
+#endif // IS_ENABLED(CONFIG_GPIO_595)
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/drivers/emul.h>
+
+/**
+ * Returns the outputs of an emulated 595 chain, with output n in bit n.
+ */
+uint32_t emul_595_get_outputs(const struct emul *target);
+
+/**
+ * Returns how many SPI transactions have written to an emulated 595 chain.
+ */
+uint32_t emul_595_get_writes(const struct emul *target);
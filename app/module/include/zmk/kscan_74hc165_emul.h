@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/drivers/emul.h>
+
+/**
+ * Sets the level of one input of an emulated 74HC165 chain, as it will be latched by the next
+ * read. Input n is bit n % 8 of register n / 8, counting from the register nearest the MCU.
+ *
+ * With output-gpios, this sets the key at row 0, the same as emul_74hc165_set_key().
+ */
+int emul_74hc165_set_input(const struct emul *target, int input, bool level);
+
+/**
+ * Sets whether the key at one row and input of an emulated matrix is pressed. A read latches an
+ * input high if any pressed key on it is in a row whose output is active at the time. The outputs
+ * must be pins of an emulated GPIO controller.
+ */
+int emul_74hc165_set_key(const struct emul *target, int row, int input, bool pressed);
+
+/**
+ * Returns how many SPI transactions have read from an emulated 74HC165 chain.
+ */
+uint32_t emul_74hc165_get_reads(const struct emul *target);
+
+/** Number of reads whose active outputs are kept for emul_74hc165_get_output_log(). */
+#define EMUL_74HC165_OUTPUT_LOG_LEN 32
+
+/**
+ * Copies which outputs were active at each read since the previous call, oldest first, as a bit
+ * mask with bit n set for output n. Only the first EMUL_74HC165_OUTPUT_LOG_LEN reads are kept.
+ *
+ * @returns the number of masks copied to @p masks, at most @p len.
+ */
+size_t emul_74hc165_get_output_log(const struct emul *target, uint32_t *masks, size_t len);
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/sys/iterable_sections.h>
+
+/**
+ * KSCAN callback that is also given the uptime in milliseconds at which the key state was read,
+ * so the resulting key event can be stamped with the time of the scan rather than the time it
+ * happens to be processed.
+ */
+typedef void (*zmk_kscan_timestamp_callback_t)(const struct device *dev, uint32_t row,
+                                               uint32_t column, bool pressed, int64_t timestamp);
+
+struct zmk_kscan_timestamp_api {
+    const struct device *device;
+    int (*config)(const struct device *dev, zmk_kscan_timestamp_callback_t callback);
+};
+
+/**
+ * Registers @p config_fn as the function that sets the timestamp callback of the KSCAN driver
+ * instance @p node_id.
+ */
+#define ZMK_KSCAN_TIMESTAMP_API_DEFINE(node_id, config_fn)                                         \
+    static const STRUCT_SECTION_ITERABLE(zmk_kscan_timestamp_api,                                  \
+                                         _CONCAT(zmk_kscan_timestamp_api_,                         \
+                                                 DEVICE_DT_NAME_GET(node_id))) = {                 \
+        .device = DEVICE_DT_GET(node_id),                                                          \
+        .config = config_fn,                                                                       \
+    }
+
+/**
+ * Configures a KSCAN device to report key state changes along with the time they were read,
+ * replacing any callback set with kscan_config().
+ *
+ * @param dev The KSCAN device.
+ * @param callback The callback to report to.
+ *
+ * @retval 0 If successful.
+ * @retval -ENOTSUP If the driver doesn't report timestamps, in which case kscan_config() has to
+ * be used instead.
+ */
+static inline int zmk_kscan_config_timestamp(const struct device *dev,
+                                             zmk_kscan_timestamp_callback_t callback) {
+    STRUCT_SECTION_FOREACH(zmk_kscan_timestamp_api, api) {
+        if (api->device == dev) {
+            return api->config(dev, callback);
+        }
+    }
+
+    return -ENOTSUP;
+}
+
+/**
+ * Reports a key state change to whichever of a driver's callbacks is set, preferring the
+ * timestamp callback.
+ */
+static inline void zmk_kscan_timestamp_report(const struct device *dev, kscan_callback_t callback,
+                                              zmk_kscan_timestamp_callback_t timestamp_callback,
+                                              uint32_t row, uint32_t column, bool pressed,
+                                              int64_t timestamp) {
+    if (timestamp_callback) {
+        timestamp_callback(dev, row, column, pressed, timestamp);
+    } else if (callback) {
+        callback(dev, row, column, pressed);
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+#include <zephyr/sys/util.h>
+
+/*
+ * A KSCAN trace is a header of ZMK_KSCAN_TRACE_MAGIC followed by ZMK_KSCAN_TRACE_VERSION, then
+ * one record per KSCAN event. Each record holds the milliseconds since the previous one, little
+ * endian, followed by the row and by the column with the pressed state in its top bit. Events on
+ * rows from ZMK_KSCAN_TRACE_DELAY_ROW up or on columns above ZMK_KSCAN_TRACE_COLUMN_MASK can't be
+ * recorded.
+ *
+ * Gaps too long to fit are padded with delay records, whose row is ZMK_KSCAN_TRACE_DELAY_ROW and
+ * whose column holds bits 16 to 23 of their delay.
+ */
+
+#define ZMK_KSCAN_TRACE_MAGIC "ZKT"
+#define ZMK_KSCAN_TRACE_VERSION 1
+#define ZMK_KSCAN_TRACE_HEADER_LEN 4
+
+#define ZMK_KSCAN_TRACE_DELAY_ROW 0xFF
+#define ZMK_KSCAN_TRACE_DELAY_MAX BIT_MASK(24)
+
+#define ZMK_KSCAN_TRACE_PRESSED BIT(7)
+#define ZMK_KSCAN_TRACE_COLUMN_MASK BIT_MASK(7)
+
+struct zmk_kscan_trace_record {
+    uint16_t delay_ms;
+    uint8_t row;
+    uint8_t column;
+} __packed;
+
+/**
+ * Adds a KSCAN event to the trace being recorded.
+ *
+ * @param timestamp The uptime in milliseconds at which the key state was read.
+ */
+void zmk_kscan_trace_record(uint32_t row, uint32_t column, bool pressed, int64_t timestamp);
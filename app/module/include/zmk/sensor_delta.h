@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <zephyr/drivers/sensor.h>
+
+/**
+ * Net change of one sensor channel that hasn't been sent on yet. Rotation readings are summed,
+ * other channels report absolute values, of which only the latest is kept.
+ */
+struct zmk_sensor_delta {
+    enum sensor_channel channel;
+    struct sensor_value value;
+    /** Rotation readings are in the older format, with steps in val2 and zero in val1. */
+    bool steps;
+    /** The latest reading of a channel other than rotation hasn't been sent yet. */
+    bool updated;
+};
+
+/**
+ * Adds a reading to a delta. Rotation readings in degrees are summed with val2 carried into
+ * val1, the same way as struct sensor_value is normalised, while readings in the older format are
+ * summed in val2 only.
+ *
+ * @param delta The delta to add to, with its channel set.
+ * @param reading The reading to add.
+ */
+void zmk_sensor_delta_add(struct zmk_sensor_delta *delta, const struct sensor_value *reading);
+
+/**
+ * Gets the value to send for a delta. A rotation in degrees of less than one degree is held
+ * back, since a zero val1 would make it read as a number of steps, and the value is zero.
+ *
+ * @param delta The delta to send.
+ * @param value Set to the value to send.
+ * @returns whether the delta has anything to send.
+ */
+bool zmk_sensor_delta_get(const struct zmk_sensor_delta *delta, struct sensor_value *value);
+
+/**
+ * Removes a value that has been sent from a delta. Readings added since the value was taken
+ * with zmk_sensor_delta_get() are kept.
+ *
+ * @param delta The delta the value was taken from.
+ * @param value The value that was sent.
+ */
+void zmk_sensor_delta_sent(struct zmk_sensor_delta *delta, const struct sensor_value *value);
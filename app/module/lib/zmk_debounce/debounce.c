@@ -27,15 +27,44 @@ static void decrement_counter(struct zmk_debounce_state *state, const int elapse
     }
 }
 
-void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, const int elapsed_ms,
-                         const struct zmk_debounce_config *config) {
+static void flip(struct zmk_debounce_state *state) {
+    state->pressed = !state->pressed;
+    state->counter = 0;
+    state->changed = true;
+}
+
+// Flips the state right away, then ignores the switch for the press or release time, depending on
+// which change this was.
+static void flip_and_lock(struct zmk_debounce_state *state,
+                          const struct zmk_debounce_config *config) {
+    const uint32_t lockout_ms = get_threshold(state, config);
+
+    flip(state);
+
+    if (lockout_ms > 0) {
+        state->locked = true;
+        increment_counter(state, lockout_ms);
+    }
+}
+
+// Returns whether the switch is still locked out after this update.
+static bool update_lockout(struct zmk_debounce_state *state, const int elapsed_ms) {
+    if (!state->locked) {
+        return false;
+    }
+
+    decrement_counter(state, elapsed_ms);
+    state->locked = state->counter > 0;
+    return true;
+}
+
+static void update_integrator(struct zmk_debounce_state *state, const bool active,
+                              const int elapsed_ms, const struct zmk_debounce_config *config) {
     // This uses a variation of the integrator debouncing described at
     // https://www.kennethkuhn.com/electronics/debounce.c
     // Every update where "active" does not match the current state, we increment
     // a counter, otherwise we decrement it. When the counter reaches a
     // threshold, the state flips and we reset the counter.
-    state->changed = false;
-
     if (active == state->pressed) {
         decrement_counter(state, elapsed_ms);
         return;
@@ -48,9 +77,63 @@ void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, co
         return;
     }
 
-    state->pressed = !state->pressed;
-    state->counter = 0;
-    state->changed = true;
+    flip(state);
+}
+
+static void update_eager_press(struct zmk_debounce_state *state, const bool active,
+                               const int elapsed_ms, const struct zmk_debounce_config *config) {
+    if (update_lockout(state, elapsed_ms)) {
+        return;
+    }
+
+    if (!state->pressed) {
+        if (active) {
+            flip_and_lock(state, config);
+        }
+        return;
+    }
+
+    // A release only counts once it has lasted the whole release time. Any bounce back to
+    // pressed starts it over.
+    if (active) {
+        state->counter = 0;
+        return;
+    }
+
+    if (state->counter < config->debounce_release_ms) {
+        increment_counter(state, elapsed_ms);
+        return;
+    }
+
+    flip(state);
+}
+
+static void update_eager(struct zmk_debounce_state *state, const bool active, const int elapsed_ms,
+                         const struct zmk_debounce_config *config) {
+    if (update_lockout(state, elapsed_ms)) {
+        return;
+    }
+
+    if (active != state->pressed) {
+        flip_and_lock(state, config);
+    }
+}
+
+void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, const int elapsed_ms,
+                         const struct zmk_debounce_config *config) {
+    state->changed = false;
+
+    switch (config->algorithm) {
+    case ZMK_DEBOUNCE_EAGER_PRESS:
+        update_eager_press(state, active, elapsed_ms, config);
+        break;
+    case ZMK_DEBOUNCE_EAGER:
+        update_eager(state, active, elapsed_ms, config);
+        break;
+    default:
+        update_integrator(state, active, elapsed_ms, config);
+        break;
+    }
 }
 
 bool zmk_debounce_is_active(const struct zmk_debounce_state *state) {
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zmk/debounce.h>
+
+// Each function below works on the counters of every switch in "lanes" at once, treating
+// counter[] as DEBOUNCE_PACKED_WIDTH vertical counters of DEBOUNCE_COUNTER_BITS bits each.
+
+static uint32_t counter_nonzero(const struct zmk_debounce_packed_state *state) {
+    uint32_t nonzero = 0;
+
+    for (int b = 0; b < DEBOUNCE_COUNTER_BITS; b++) {
+        nonzero |= state->counter[b];
+    }
+
+    return nonzero;
+}
+
+// Returns the mask of switches whose counter is at least value.
+static uint32_t counter_at_least(const struct zmk_debounce_packed_state *state,
+                                 const uint32_t value) {
+    if (value > DEBOUNCE_COUNTER_MAX) {
+        return 0;
+    }
+
+    // Compare from the most significant bit down, tracking which counters are already known to
+    // be greater and which are equal so far.
+    uint32_t greater = 0;
+    uint32_t equal = UINT32_MAX;
+
+    for (int b = DEBOUNCE_COUNTER_BITS - 1; b >= 0; b--) {
+        if (value & BIT(b)) {
+            equal &= state->counter[b];
+        } else {
+            greater |= equal & state->counter[b];
+            equal &= ~state->counter[b];
+        }
+    }
+
+    return greater | equal;
+}
+
+// Counters must be below DEBOUNCE_COUNTER_MAX.
+static void counter_increment(struct zmk_debounce_packed_state *state, const uint32_t lanes) {
+    uint32_t carry = lanes;
+
+    for (int b = 0; b < DEBOUNCE_COUNTER_BITS && carry; b++) {
+        const uint32_t plane = state->counter[b];
+
+        state->counter[b] = plane ^ carry;
+        carry &= plane;
+    }
+}
+
+// Counters must be nonzero.
+static void counter_decrement(struct zmk_debounce_packed_state *state, const uint32_t lanes) {
+    uint32_t borrow = lanes;
+
+    for (int b = 0; b < DEBOUNCE_COUNTER_BITS && borrow; b++) {
+        const uint32_t plane = state->counter[b];
+
+        state->counter[b] = plane ^ borrow;
+        borrow &= ~plane;
+    }
+}
+
+static void counter_set(struct zmk_debounce_packed_state *state, const uint32_t lanes,
+                        const uint32_t value) {
+    for (int b = 0; b < DEBOUNCE_COUNTER_BITS; b++) {
+        state->counter[b] = (state->counter[b] & ~lanes) | ((value & BIT(b)) ? lanes : 0);
+    }
+}
+
+// Returns the mask of switches whose counter has reached the threshold for their current state.
+static uint32_t threshold_reached(const struct zmk_debounce_packed_state *state,
+                                  const uint32_t press_scans, const uint32_t release_scans) {
+    return (state->pressed & counter_at_least(state, release_scans)) |
+           (~state->pressed & counter_at_least(state, press_scans));
+}
+
+static void flip_and_lock(struct zmk_debounce_packed_state *state, const uint32_t lanes,
+                          const uint32_t press_scans, const uint32_t release_scans) {
+    const uint32_t presses = lanes & ~state->pressed;
+    const uint32_t releases = lanes & state->pressed;
+
+    counter_set(state, presses, press_scans);
+    counter_set(state, releases, release_scans);
+
+    state->locked |= (press_scans > 0 ? presses : 0) | (release_scans > 0 ? releases : 0);
+    state->pressed ^= lanes;
+}
+
+// Returns the mask of switches that were locked out before this update.
+static uint32_t update_lockout(struct zmk_debounce_packed_state *state) {
+    const uint32_t locked = state->locked;
+
+    counter_decrement(state, locked);
+    state->locked &= counter_nonzero(state);
+
+    return locked;
+}
+
+static uint32_t update_integrator(struct zmk_debounce_packed_state *state, const uint32_t active,
+                                  const uint32_t press_scans, const uint32_t release_scans) {
+    const uint32_t differs = active ^ state->pressed;
+    const uint32_t reached = threshold_reached(state, press_scans, release_scans);
+    const uint32_t flipped = differs & reached;
+
+    counter_decrement(state, ~differs & counter_nonzero(state));
+    counter_increment(state, differs & ~reached);
+    counter_set(state, flipped, 0);
+    state->pressed ^= flipped;
+
+    return flipped;
+}
+
+static uint32_t update_eager_press(struct zmk_debounce_packed_state *state, const uint32_t active,
+                                   const uint32_t press_scans, const uint32_t release_scans) {
+    const uint32_t unlocked = ~update_lockout(state);
+    const uint32_t pressed = state->pressed & unlocked;
+    const uint32_t presses = ~state->pressed & unlocked & active;
+    const uint32_t releasing = pressed & ~active;
+    const uint32_t releases = releasing & counter_at_least(state, release_scans);
+
+    // A release only counts once it has lasted the whole release time. Any bounce back to
+    // pressed starts it over.
+    counter_set(state, pressed & active, 0);
+    counter_increment(state, releasing & ~releases);
+    counter_set(state, releases, 0);
+    state->pressed ^= releases;
+
+    flip_and_lock(state, presses, press_scans, release_scans);
+
+    return presses | releases;
+}
+
+static uint32_t update_eager(struct zmk_debounce_packed_state *state, const uint32_t active,
+                             const uint32_t press_scans, const uint32_t release_scans) {
+    const uint32_t unlocked = ~update_lockout(state);
+    const uint32_t flipped = (active ^ state->pressed) & unlocked;
+
+    flip_and_lock(state, flipped, press_scans, release_scans);
+
+    return flipped;
+}
+
+uint32_t zmk_debounce_packed_update(struct zmk_debounce_packed_state *state, const uint32_t active,
+                                    const int elapsed_ms,
+                                    const struct zmk_debounce_config *config) {
+    // zmk_debounce_update() adds elapsed_ms to its counter on every update and compares it with
+    // the debounce time, which takes this many updates to reach.
+    const int scan_ms = MAX(elapsed_ms, 1);
+    const uint32_t press_scans = DIV_ROUND_UP(config->debounce_press_ms, scan_ms);
+    const uint32_t release_scans = DIV_ROUND_UP(config->debounce_release_ms, scan_ms);
+
+    switch (config->algorithm) {
+    case ZMK_DEBOUNCE_EAGER_PRESS:
+        return update_eager_press(state, active, press_scans, release_scans);
+    case ZMK_DEBOUNCE_EAGER:
+        return update_eager(state, active, press_scans, release_scans);
+    default:
+        return update_integrator(state, active, press_scans, release_scans);
+    }
+}
+
+uint32_t zmk_debounce_packed_get_active(const struct zmk_debounce_packed_state *state) {
+    return state->pressed | counter_nonzero(state);
+}
+
+uint32_t zmk_debounce_packed_get_pressed(const struct zmk_debounce_packed_state *state) {
+    return state->pressed;
+}
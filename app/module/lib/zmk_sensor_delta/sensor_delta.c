@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zmk/sensor_delta.h>
+
+#define MICRO_PER_UNIT 1000000
+
+static int64_t to_micro(const struct sensor_value *value) {
+    return (int64_t)value->val1 * MICRO_PER_UNIT + value->val2;
+}
+
+// Division truncates toward zero, so val2 always has the same sign as val1.
+static struct sensor_value from_micro(int64_t micro) {
+    return (struct sensor_value){.val1 = micro / MICRO_PER_UNIT, .val2 = micro % MICRO_PER_UNIT};
+}
+
+void zmk_sensor_delta_add(struct zmk_sensor_delta *delta, const struct sensor_value *reading) {
+    if (delta->channel != SENSOR_CHAN_ROTATION) {
+        delta->value = *reading;
+        delta->updated = true;
+        return;
+    }
+
+    delta->steps = reading->val1 == 0;
+
+    if (delta->steps) {
+        delta->value.val2 += reading->val2;
+    } else {
+        delta->value = from_micro(to_micro(&delta->value) + to_micro(reading));
+    }
+}
+
+bool zmk_sensor_delta_get(const struct zmk_sensor_delta *delta, struct sensor_value *value) {
+    if (delta->channel != SENSOR_CHAN_ROTATION) {
+        *value = delta->value;
+        return delta->updated;
+    }
+
+    if (delta->steps) {
+        *value = delta->value;
+        return delta->value.val2 != 0;
+    }
+
+    if (delta->value.val1 == 0) {
+        *value = (struct sensor_value){0};
+        return false;
+    }
+
+    *value = delta->value;
+    return true;
+}
+
+void zmk_sensor_delta_sent(struct zmk_sensor_delta *delta, const struct sensor_value *value) {
+    if (delta->channel != SENSOR_CHAN_ROTATION) {
+        if (delta->value.val1 == value->val1 && delta->value.val2 == value->val2) {
+            delta->updated = false;
+        }
+        return;
+    }
+
+    if (delta->steps) {
+        delta->value.val2 -= value->val2;
+    } else {
+        delta->value = from_micro(to_micro(&delta->value) - to_micro(value));
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/irq_offload.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+#include <zmk/gpio_595.h>
+#include <zmk/gpio_595_emul.h>
+
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define SHIFTER_NODE DT_NODELABEL(shifter)
+#define DEMUX_NODE DT_NODELABEL(kscan_demux)
+#define NGPIOS DT_PROP(SHIFTER_NODE, ngpios)
+#define POLL_PERIOD_MS DT_PROP(DEMUX_NODE, polling_interval_msec)
+
+static const struct device *shifter = DEVICE_DT_GET(SHIFTER_NODE);
+static const struct emul *emul = EMUL_DT_GET(SHIFTER_NODE);
+static const struct device *demux = DEVICE_DT_GET(DEMUX_NODE);
+
+static void set_pin_from_isr(const void *pin) { gpio_pin_set(shifter, (uintptr_t)pin, 1); }
+
+static void gpio_595_before(void *fixture) {
+    zassert_ok(zmk_gpio_595_flush(shifter));
+    zassert_ok(gpio_port_clear_bits_raw(shifter, BIT_MASK(NGPIOS)));
+    zassert_equal(emul_595_get_outputs(emul), 0);
+}
+
+ZTEST(gpio_595, test_unchanged_pins_are_not_written) {
+    const uint32_t writes = emul_595_get_writes(emul);
+
+    zassert_ok(gpio_pin_set(shifter, 3, 1));
+    zassert_equal(emul_595_get_writes(emul), writes + 1);
+    zassert_equal(emul_595_get_outputs(emul), BIT(3));
+
+    zassert_ok(gpio_pin_set(shifter, 3, 1));
+    zassert_equal(emul_595_get_writes(emul), writes + 1);
+}
+
+ZTEST(gpio_595, test_deferred_writes_are_batched) {
+    const uint32_t writes = emul_595_get_writes(emul);
+
+    zassert_ok(zmk_gpio_595_defer(shifter));
+    zassert_ok(gpio_pin_set(shifter, 1, 1));
+    zassert_ok(gpio_pin_set(shifter, 8, 1));
+    zassert_ok(gpio_pin_set(shifter, 15, 1));
+
+    zassert_equal(emul_595_get_writes(emul), writes);
+    zassert_equal(emul_595_get_outputs(emul), 0);
+
+    zassert_ok(zmk_gpio_595_flush(shifter));
+
+    zassert_equal(emul_595_get_writes(emul), writes + 1);
+    zassert_equal(emul_595_get_outputs(emul), BIT(1) | BIT(8) | BIT(15));
+}
+
+ZTEST(gpio_595, test_isr_write) {
+    const uint32_t writes = emul_595_get_writes(emul);
+
+    irq_offload(set_pin_from_isr, (const void *)5);
+    k_sleep(K_MSEC(1));
+
+    zassert_equal(emul_595_get_writes(emul), writes + 1);
+    zassert_equal(emul_595_get_outputs(emul), BIT(5));
+}
+
+ZTEST(gpio_595, test_isr_write_during_batch_waits_for_flush) {
+    const uint32_t writes = emul_595_get_writes(emul);
+
+    zassert_ok(zmk_gpio_595_defer(shifter));
+    zassert_ok(gpio_pin_set(shifter, 2, 1));
+    irq_offload(set_pin_from_isr, (const void *)4);
+    k_sleep(K_MSEC(1));
+
+    zassert_equal(emul_595_get_writes(emul), writes);
+
+    zassert_ok(zmk_gpio_595_flush(shifter));
+
+    zassert_equal(emul_595_get_writes(emul), writes + 1);
+    zassert_equal(emul_595_get_outputs(emul), BIT(2) | BIT(4));
+}
+
+ZTEST(gpio_595, test_batching_needs_a_595) {
+    const struct device *gpio0 = DEVICE_DT_GET(DT_NODELABEL(gpio0));
+
+    zassert_equal(zmk_gpio_595_defer(gpio0), -ENOTSUP);
+    zassert_equal(zmk_gpio_595_flush(gpio0), -ENOTSUP);
+}
+
+ZTEST_SUITE(gpio_595, NULL, NULL, gpio_595_before, NULL, NULL);
+
+static void kscan_callback(const struct device *dev, uint32_t row, uint32_t column, bool pressed) {}
+
+static void kscan_demux_after(void *fixture) { kscan_disable_callback(demux); }
+
+ZTEST(kscan_demux_595, test_one_write_per_output) {
+    zassert_true(device_is_ready(demux));
+    zassert_ok(kscan_config(demux, kscan_callback));
+    zassert_ok(kscan_enable_callback(demux));
+
+    // Sample between scans.
+    k_sleep(K_MSEC(POLL_PERIOD_MS + (POLL_PERIOD_MS / 2)));
+
+    const uint32_t writes = emul_595_get_writes(emul);
+    const int scans = 10;
+
+    k_sleep(K_MSEC(scans * POLL_PERIOD_MS));
+
+    // Both address pins are on the chain, so each of the four outputs is selected in a single
+    // write, instead of one per address pin that changes.
+    const uint32_t scan_writes = emul_595_get_writes(emul) - writes;
+
+    zassert_within(scan_writes, scans * 4, 2, "%u writes in %d scans", scan_writes, scans);
+}
+
+ZTEST_SUITE(kscan_demux_595, NULL, NULL, NULL, kscan_demux_after, NULL);
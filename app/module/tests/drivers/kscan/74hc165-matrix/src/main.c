@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+#include <zmk/kscan_74hc165_emul.h>
+#include <zmk/kscan_timestamp.h>
+
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define KSCAN_NODE DT_NODELABEL(kscan_74hc165)
+#define ROWS DT_PROP_LEN(KSCAN_NODE, output_gpios)
+#define INPUTS DT_PROP(KSCAN_NODE, inputs)
+#define DEBOUNCE_MS DT_PROP(KSCAN_NODE, debounce_press_ms)
+#define SCAN_PERIOD_MS DT_PROP(KSCAN_NODE, debounce_scan_period_ms)
+#define POLL_PERIOD_MS DT_PROP(KSCAN_NODE, poll_period_ms)
+
+// Long enough for the next poll to see a change and the debouncer to accept it.
+#define SETTLE_MS (POLL_PERIOD_MS + DEBOUNCE_MS + 2 * SCAN_PERIOD_MS)
+
+#define MAX_EVENTS 16
+
+#define OUTPUT_SPEC(idx, _) GPIO_DT_SPEC_GET_BY_IDX(KSCAN_NODE, output_gpios, idx)
+
+struct kscan_event {
+    uint32_t row;
+    uint32_t column;
+    bool pressed;
+    int64_t timestamp;
+};
+
+static const struct device *kscan = DEVICE_DT_GET(KSCAN_NODE);
+static const struct emul *emul = EMUL_DT_GET(KSCAN_NODE);
+static const struct gpio_dt_spec outputs[] = {LISTIFY(ROWS, OUTPUT_SPEC, (, ))};
+
+static struct kscan_event events[MAX_EVENTS];
+static int event_count;
+
+static void kscan_callback(const struct device *dev, uint32_t row, uint32_t column, bool pressed,
+                           int64_t timestamp) {
+    if (event_count < MAX_EVENTS) {
+        events[event_count] = (struct kscan_event){
+            .row = row,
+            .column = column,
+            .pressed = pressed,
+            .timestamp = timestamp,
+        };
+    }
+
+    event_count++;
+}
+
+static void assert_event(int index, uint32_t row, uint32_t column, bool pressed) {
+    zassert_true(index < event_count, "missing event %d", index);
+    zassert_equal(events[index].row, row, "event %d", index);
+    zassert_equal(events[index].column, column, "event %d", index);
+    zassert_equal(events[index].pressed, pressed, "event %d", index);
+}
+
+static void *kscan_74hc165_matrix_setup(void) {
+    zassert_true(device_is_ready(kscan));
+    zassert_ok(zmk_kscan_config_timestamp(kscan, kscan_callback));
+    zassert_ok(kscan_enable_callback(kscan));
+
+    return NULL;
+}
+
+static void kscan_74hc165_matrix_before(void *fixture) {
+    for (int row = 0; row < ROWS; row++) {
+        for (int i = 0; i < INPUTS; i++) {
+            emul_74hc165_set_key(emul, row, i, false);
+        }
+    }
+
+    k_sleep(K_MSEC(SETTLE_MS));
+    event_count = 0;
+}
+
+ZTEST(kscan_74hc165_matrix, test_press_release) {
+    emul_74hc165_set_key(emul, 2, INPUTS - 1, true);
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    zassert_equal(event_count, 1);
+    assert_event(0, 2, INPUTS - 1, true);
+
+    emul_74hc165_set_key(emul, 2, INPUTS - 1, false);
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    zassert_equal(event_count, 2);
+    assert_event(1, 2, INPUTS - 1, false);
+}
+
+ZTEST(kscan_74hc165_matrix, test_keys_in_each_row) {
+    static const struct {
+        int row;
+        int input;
+    } keys[] = {{0, 0}, {1, 8}, {2, 3}};
+
+    for (int i = 0; i < ARRAY_SIZE(keys); i++) {
+        emul_74hc165_set_key(emul, keys[i].row, keys[i].input, true);
+    }
+
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    // Presses read in the same scan are reported together, in row then column order.
+    zassert_equal(event_count, ARRAY_SIZE(keys));
+    for (int i = 0; i < ARRAY_SIZE(keys); i++) {
+        assert_event(i, keys[i].row, keys[i].input, true);
+        zassert_equal(events[i].timestamp, events[0].timestamp);
+    }
+}
+
+ZTEST(kscan_74hc165_matrix, test_rows_sharing_an_input) {
+    emul_74hc165_set_key(emul, 0, 4, true);
+    emul_74hc165_set_key(emul, 2, 4, true);
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    // Each key is only read while its own row is driven, so the row between them stays released.
+    zassert_equal(event_count, 2);
+    assert_event(0, 0, 4, true);
+    assert_event(1, 2, 4, true);
+}
+
+ZTEST(kscan_74hc165_matrix, test_drive_release_sequence) {
+    uint32_t masks[EMUL_74HC165_OUTPUT_LOG_LEN];
+
+    emul_74hc165_get_output_log(emul, masks, ARRAY_SIZE(masks));
+    k_sleep(K_MSEC(3 * POLL_PERIOD_MS));
+
+    // Every scan drives the outputs one at a time, in order, reading the chain for each.
+    const size_t count = emul_74hc165_get_output_log(emul, masks, ARRAY_SIZE(masks));
+
+    zassert_true(count >= ROWS, "%zu reads", count);
+    zassert_equal(count % ROWS, 0, "%zu reads", count);
+    for (int i = 0; i < count; i++) {
+        zassert_equal(masks[i], BIT(i % ROWS), "read %d drove outputs 0x%x", i, masks[i]);
+    }
+
+    // Between scans, every output is released.
+    for (int i = 0; i < ROWS; i++) {
+        zassert_equal(gpio_emul_output_get(outputs[i].port, outputs[i].pin), 0, "output %d", i);
+    }
+}
+
+ZTEST_SUITE(kscan_74hc165_matrix, NULL, kscan_74hc165_matrix_setup, kscan_74hc165_matrix_before,
+            NULL, NULL);
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/ztest.h>
+
+#include <zmk/kscan_74hc165_emul.h>
+#include <zmk/kscan_timestamp.h>
+
+LOG_MODULE_REGISTER(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define KSCAN_NODE DT_NODELABEL(kscan_74hc165)
+#define INPUTS DT_PROP(KSCAN_NODE, inputs)
+#define DEBOUNCE_MS DT_PROP(KSCAN_NODE, debounce_press_ms)
+#define SCAN_PERIOD_MS DT_PROP(KSCAN_NODE, debounce_scan_period_ms)
+#define POLL_PERIOD_MS DT_PROP(KSCAN_NODE, poll_period_ms)
+
+// Long enough for the next poll to see a change and the debouncer to accept it.
+#define SETTLE_MS (POLL_PERIOD_MS + DEBOUNCE_MS + 2 * SCAN_PERIOD_MS)
+
+#define MAX_EVENTS 16
+
+struct kscan_event {
+    uint32_t row;
+    uint32_t column;
+    bool pressed;
+    int64_t timestamp;
+};
+
+static const struct device *kscan = DEVICE_DT_GET(KSCAN_NODE);
+static const struct emul *emul = EMUL_DT_GET(KSCAN_NODE);
+
+static struct kscan_event events[MAX_EVENTS];
+static int event_count;
+
+static void kscan_callback(const struct device *dev, uint32_t row, uint32_t column, bool pressed,
+                           int64_t timestamp) {
+    if (event_count < MAX_EVENTS) {
+        events[event_count] = (struct kscan_event){
+            .row = row,
+            .column = column,
+            .pressed = pressed,
+            .timestamp = timestamp,
+        };
+    }
+
+    event_count++;
+}
+
+static void assert_event(int index, uint32_t column, bool pressed) {
+    zassert_true(index < event_count, "missing event %d", index);
+    zassert_equal(events[index].row, 0, "event %d", index);
+    zassert_equal(events[index].column, column, "event %d", index);
+    zassert_equal(events[index].pressed, pressed, "event %d", index);
+}
+
+static void *kscan_74hc165_setup(void) {
+    zassert_true(device_is_ready(kscan));
+    zassert_ok(zmk_kscan_config_timestamp(kscan, kscan_callback));
+    zassert_ok(kscan_enable_callback(kscan));
+
+    return NULL;
+}
+
+static void kscan_74hc165_before(void *fixture) {
+    for (int i = 0; i < INPUTS; i++) {
+        emul_74hc165_set_input(emul, i, false);
+    }
+
+    k_sleep(K_MSEC(SETTLE_MS));
+    event_count = 0;
+}
+
+ZTEST(kscan_74hc165, test_press_release) {
+    emul_74hc165_set_input(emul, 3, true);
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    zassert_equal(event_count, 1);
+    assert_event(0, 3, true);
+
+    emul_74hc165_set_input(emul, 3, false);
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    zassert_equal(event_count, 2);
+    assert_event(1, 3, false);
+}
+
+ZTEST(kscan_74hc165, test_inputs_across_registers) {
+    static const int inputs[] = {0, 7, 8, INPUTS - 1};
+
+    for (int i = 0; i < ARRAY_SIZE(inputs); i++) {
+        emul_74hc165_set_input(emul, inputs[i], true);
+    }
+
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    // Presses read in the same scan are reported together, in input order.
+    zassert_equal(event_count, ARRAY_SIZE(inputs));
+    for (int i = 0; i < ARRAY_SIZE(inputs); i++) {
+        assert_event(i, inputs[i], true);
+        zassert_equal(events[i].timestamp, events[0].timestamp);
+    }
+}
+
+ZTEST(kscan_74hc165, test_one_read_per_scan) {
+    emul_74hc165_set_input(emul, 5, true);
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    // While a key is held, the driver scans every debounce-scan-period-ms, reading the whole
+    // chain in a single SPI transaction each time.
+    const uint32_t reads = emul_74hc165_get_reads(emul);
+    const int hold_ms = 20 * SCAN_PERIOD_MS;
+
+    k_sleep(K_MSEC(hold_ms));
+
+    const uint32_t scans = emul_74hc165_get_reads(emul) - reads;
+
+    zassert_within(scans, hold_ms / SCAN_PERIOD_MS, 1, "%u reads in %d ms", scans, hold_ms);
+}
+
+ZTEST(kscan_74hc165, test_idle_polling) {
+    const uint32_t reads = emul_74hc165_get_reads(emul);
+
+    k_sleep(K_MSEC(10 * POLL_PERIOD_MS));
+
+    const uint32_t scans = emul_74hc165_get_reads(emul) - reads;
+
+    zassert_equal(event_count, 0);
+    zassert_within(scans, 10, 1, "%u reads while idle", scans);
+}
+
+ZTEST_SUITE(kscan_74hc165, NULL, kscan_74hc165_setup, kscan_74hc165_before, NULL, NULL);
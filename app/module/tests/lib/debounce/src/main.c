@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+#include <zephyr/ztest.h>
+
+#include <zmk/debounce.h>
+
+#define SCAN_PERIOD_MS 1
+#define DEBOUNCE_MS 5
+
+struct debounce_result {
+    int presses;
+    int releases;
+    /** Time from the first pressed sample to the first reported press, or -1. */
+    int press_latency_ms;
+    /** Time from the start of the release to the first reported release, or -1. */
+    int release_latency_ms;
+    /** Whether the debouncer still wanted fast scans after the last sample. */
+    bool active;
+};
+
+static const struct zmk_debounce_config configs[] = {
+    {DEBOUNCE_MS, DEBOUNCE_MS, ZMK_DEBOUNCE_INTEGRATOR},
+    {DEBOUNCE_MS, DEBOUNCE_MS, ZMK_DEBOUNCE_EAGER_PRESS},
+    {DEBOUNCE_MS, DEBOUNCE_MS, ZMK_DEBOUNCE_EAGER},
+};
+
+static const char *const names[] = {"integrator", "eager-press", "eager"};
+
+/**
+ * Debounces a signal given as one character per scan, '1' for pressed and '0' for released.
+ * The release is taken to start at sample release_start, which bounces may follow.
+ */
+static struct debounce_result debounce(const struct zmk_debounce_config *config,
+                                       const char *signal, int release_start) {
+    struct zmk_debounce_state state = {0};
+    struct debounce_result result = {.press_latency_ms = -1, .release_latency_ms = -1};
+    const int first_pressed = strcspn(signal, "1");
+
+    for (int i = 0; signal[i] != '\0'; i++) {
+        const bool active = signal[i] == '1';
+
+        zmk_debounce_update(&state, active, SCAN_PERIOD_MS, config);
+
+        if (!zmk_debounce_get_changed(&state)) {
+            continue;
+        }
+
+        if (zmk_debounce_is_pressed(&state)) {
+            result.presses++;
+            if (result.press_latency_ms < 0) {
+                result.press_latency_ms = (i - first_pressed) * SCAN_PERIOD_MS;
+            }
+        } else {
+            result.releases++;
+            if (result.release_latency_ms < 0) {
+                result.release_latency_ms = (i - release_start) * SCAN_PERIOD_MS;
+            }
+        }
+    }
+
+    result.active = zmk_debounce_is_active(&state);
+
+    return result;
+}
+
+#define PRESS_CLEAN "00000" "11111111111111111111"
+#define PRESS_BOUNCY "00000" "1011" "1111111111111111"
+
+ZTEST(debounce, test_clean_keystroke_latency) {
+    static const char signal[] = PRESS_CLEAN "00000000000000000000";
+    static const int press_latency_ms[] = {DEBOUNCE_MS, 0, 0};
+    static const int release_latency_ms[] = {DEBOUNCE_MS, DEBOUNCE_MS, 0};
+
+    for (int i = 0; i < ARRAY_SIZE(configs); i++) {
+        struct debounce_result result = debounce(&configs[i], signal, strlen(PRESS_CLEAN));
+
+        TC_PRINT("%s: press latency %d ms, release latency %d ms\n", names[i],
+                 result.press_latency_ms, result.release_latency_ms);
+
+        zassert_equal(result.presses, 1, "%s", names[i]);
+        zassert_equal(result.releases, 1, "%s", names[i]);
+        zassert_equal(result.press_latency_ms, press_latency_ms[i], "%s", names[i]);
+        zassert_equal(result.release_latency_ms, release_latency_ms[i], "%s", names[i]);
+        zassert_false(result.active, "%s", names[i]);
+    }
+}
+
+ZTEST(debounce, test_bounce_rejection) {
+    // Contacts that bounce for a few milliseconds on both press and release.
+    static const char signal[] = PRESS_BOUNCY "0100" "0000000000000000";
+    // The integrator restarts its count whenever the contacts bounce back.
+    static const int press_latency_ms[] = {DEBOUNCE_MS + 2, 0, 0};
+    static const int release_latency_ms[] = {DEBOUNCE_MS + 2, DEBOUNCE_MS + 2, 0};
+
+    for (int i = 0; i < ARRAY_SIZE(configs); i++) {
+        struct debounce_result result = debounce(&configs[i], signal, strlen(PRESS_BOUNCY));
+
+        TC_PRINT("%s: press latency %d ms, release latency %d ms\n", names[i],
+                 result.press_latency_ms, result.release_latency_ms);
+
+        zassert_equal(result.presses, 1, "%s", names[i]);
+        zassert_equal(result.releases, 1, "%s", names[i]);
+        zassert_equal(result.press_latency_ms, press_latency_ms[i], "%s", names[i]);
+        zassert_equal(result.release_latency_ms, release_latency_ms[i], "%s", names[i]);
+        zassert_false(result.active, "%s", names[i]);
+    }
+}
+
+ZTEST(debounce, test_noise_spike) {
+    static const char signal[] = "00000" "1" "00000000000000000000";
+
+    // Only the integrator filters out noise on a released key. The eager algorithms report it as
+    // a short keystroke.
+    static const int presses[] = {0, 1, 1};
+
+    for (int i = 0; i < ARRAY_SIZE(configs); i++) {
+        struct debounce_result result = debounce(&configs[i], signal, strlen("000001"));
+
+        zassert_equal(result.presses, presses[i], "%s", names[i]);
+        zassert_equal(result.releases, presses[i], "%s", names[i]);
+        zassert_false(result.active, "%s", names[i]);
+    }
+}
+
+ZTEST(debounce, test_eager_lockout_keeps_scanning) {
+    const struct zmk_debounce_config *config = &configs[ZMK_DEBOUNCE_EAGER];
+    struct zmk_debounce_state state = {0};
+
+    zmk_debounce_update(&state, true, SCAN_PERIOD_MS, config);
+    zassert_true(zmk_debounce_get_changed(&state));
+
+    for (int i = 0; i < DEBOUNCE_MS; i++) {
+        zmk_debounce_update(&state, false, SCAN_PERIOD_MS, config);
+        zassert_false(zmk_debounce_get_changed(&state), "changed during lockout at %d ms", i);
+    }
+
+    zmk_debounce_update(&state, false, SCAN_PERIOD_MS, config);
+    zassert_true(zmk_debounce_get_changed(&state));
+    zassert_false(zmk_debounce_is_pressed(&state));
+
+    // The release starts a lockout of its own, which needs scans to count down.
+    zassert_true(zmk_debounce_is_active(&state));
+}
+
+ZTEST(debounce, test_eager_lockout_times) {
+    const struct zmk_debounce_config config = {
+        .debounce_press_ms = 2, .debounce_release_ms = 7, .algorithm = ZMK_DEBOUNCE_EAGER};
+    struct zmk_debounce_state state = {0};
+    int locked_ms = 0;
+
+    // A press is followed by the press time of lockout, and a release by the release time.
+    zmk_debounce_update(&state, true, SCAN_PERIOD_MS, &config);
+    do {
+        zmk_debounce_update(&state, false, SCAN_PERIOD_MS, &config);
+        locked_ms += SCAN_PERIOD_MS;
+    } while (!zmk_debounce_get_changed(&state));
+    zassert_equal(locked_ms, config.debounce_press_ms + SCAN_PERIOD_MS);
+
+    locked_ms = 0;
+    do {
+        zmk_debounce_update(&state, true, SCAN_PERIOD_MS, &config);
+        locked_ms += SCAN_PERIOD_MS;
+    } while (!zmk_debounce_get_changed(&state));
+    zassert_equal(locked_ms, config.debounce_release_ms + SCAN_PERIOD_MS);
+}
+
+ZTEST(debounce, test_zero_debounce_time) {
+    static const char signal[] = "0101";
+
+    for (int i = 0; i < ARRAY_SIZE(configs); i++) {
+        struct zmk_debounce_config config = configs[i];
+
+        config.debounce_press_ms = 0;
+        config.debounce_release_ms = 0;
+
+        struct debounce_result result = debounce(&config, signal, strlen("01"));
+
+        zassert_equal(result.presses, 2, "%s", names[i]);
+        zassert_equal(result.releases, 1, "%s", names[i]);
+        zassert_equal(result.press_latency_ms, 0, "%s", names[i]);
+        zassert_equal(result.release_latency_ms, 0, "%s", names[i]);
+    }
+}
+
+ZTEST(debounce, test_packed_matches_per_key) {
+    static const int scan_periods_ms[] = {1, 2, 3};
+    static const uint32_t debounce_times_ms[][2] = {{0, 0}, {5, 5}, {1, 7}, {8, 3}};
+    uint32_t random = 0x2545f491;
+
+    for (int alg = 0; alg < ARRAY_SIZE(configs); alg++) {
+        for (int p = 0; p < ARRAY_SIZE(scan_periods_ms); p++) {
+            for (int t = 0; t < ARRAY_SIZE(debounce_times_ms); t++) {
+                const struct zmk_debounce_config config = {
+                    .debounce_press_ms = debounce_times_ms[t][0],
+                    .debounce_release_ms = debounce_times_ms[t][1],
+                    .algorithm = alg,
+                };
+                struct zmk_debounce_state states[DEBOUNCE_PACKED_WIDTH] = {0};
+                struct zmk_debounce_packed_state packed = {0};
+
+                for (int scan = 0; scan < 500; scan++) {
+                    // Switches that mostly hold their state, with the odd bounce.
+                    random ^= random << 13;
+                    random ^= random >> 17;
+                    random ^= random << 5;
+                    const uint32_t active = (scan / 20) % 2 ? ~(random & (random >> 3))
+                                                            : random & (random >> 3);
+
+                    const uint32_t changed =
+                        zmk_debounce_packed_update(&packed, active, scan_periods_ms[p], &config);
+
+                    for (int i = 0; i < DEBOUNCE_PACKED_WIDTH; i++) {
+                        struct zmk_debounce_state *state = &states[i];
+
+                        zmk_debounce_update(state, active & BIT(i), scan_periods_ms[p], &config);
+
+                        zassert_equal(zmk_debounce_get_changed(state), !!(changed & BIT(i)),
+                                      "%s scan %d switch %d", names[alg], scan, i);
+                        zassert_equal(zmk_debounce_is_pressed(state),
+                                      !!(zmk_debounce_packed_get_pressed(&packed) & BIT(i)),
+                                      "%s scan %d switch %d", names[alg], scan, i);
+                        zassert_equal(zmk_debounce_is_active(state),
+                                      !!(zmk_debounce_packed_get_active(&packed) & BIT(i)),
+                                      "%s scan %d switch %d", names[alg], scan, i);
+                    }
+                }
+            }
+        }
+    }
+}
+
+ZTEST_SUITE(debounce, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/ztest.h>
+
+#include <zmk/sensor_delta.h>
+
+static void add(struct zmk_sensor_delta *delta, int32_t val1, int32_t val2) {
+    const struct sensor_value reading = {.val1 = val1, .val2 = val2};
+
+    zmk_sensor_delta_add(delta, &reading);
+}
+
+static void assert_value(const struct sensor_value *value, int32_t val1, int32_t val2) {
+    zassert_equal(value->val1, val1, "val1 %d, expected %d", value->val1, val1);
+    zassert_equal(value->val2, val2, "val2 %d, expected %d", value->val2, val2);
+}
+
+ZTEST(sensor_delta, test_steps_are_summed) {
+    struct zmk_sensor_delta delta = {.channel = SENSOR_CHAN_ROTATION};
+    struct sensor_value value;
+
+    add(&delta, 0, 1);
+    add(&delta, 0, 1);
+    add(&delta, 0, -1);
+    add(&delta, 0, 1);
+
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, 0, 2);
+
+    zmk_sensor_delta_sent(&delta, &value);
+    zassert_false(zmk_sensor_delta_get(&delta, &value));
+}
+
+ZTEST(sensor_delta, test_degrees_carry) {
+    struct zmk_sensor_delta delta = {.channel = SENSOR_CHAN_ROTATION};
+    struct sensor_value value;
+
+    add(&delta, 15, 500000);
+    add(&delta, 15, 700000);
+
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, 31, 200000);
+
+    zmk_sensor_delta_sent(&delta, &value);
+    add(&delta, -15, -500000);
+    add(&delta, -15, -600000);
+
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, -31, -100000);
+}
+
+ZTEST(sensor_delta, test_fraction_of_a_degree_is_held_back) {
+    struct zmk_sensor_delta delta = {.channel = SENSOR_CHAN_ROTATION};
+    struct sensor_value value;
+
+    add(&delta, 15, 300000);
+    add(&delta, -15, 0);
+
+    // Sent as is, val1 0 and val2 300000 would read as 300000 steps.
+    zassert_false(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, 0, 0);
+
+    add(&delta, 14, 800000);
+
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, 15, 100000);
+}
+
+ZTEST(sensor_delta, test_readings_during_send_are_kept) {
+    struct zmk_sensor_delta delta = {.channel = SENSOR_CHAN_ROTATION};
+    struct sensor_value value;
+
+    add(&delta, 15, 0);
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+
+    add(&delta, 15, 0);
+    add(&delta, 15, 0);
+    zmk_sensor_delta_sent(&delta, &value);
+
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, 30, 0);
+}
+
+ZTEST(sensor_delta, test_unsent_delta_is_kept) {
+    struct zmk_sensor_delta delta = {.channel = SENSOR_CHAN_ROTATION};
+    struct sensor_value value;
+
+    add(&delta, 0, 1);
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+
+    // The notification failed, so zmk_sensor_delta_sent() is never called.
+    add(&delta, 0, 1);
+
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, 0, 2);
+}
+
+ZTEST(sensor_delta, test_absolute_channel_keeps_latest) {
+    struct zmk_sensor_delta delta = {.channel = SENSOR_CHAN_AMBIENT_TEMP};
+    struct sensor_value value;
+
+    zassert_false(zmk_sensor_delta_get(&delta, &value));
+
+    add(&delta, 20, 0);
+    add(&delta, 21, 500000);
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, 21, 500000);
+
+    add(&delta, 22, 0);
+    zmk_sensor_delta_sent(&delta, &value);
+
+    zassert_true(zmk_sensor_delta_get(&delta, &value));
+    assert_value(&value, 22, 0);
+
+    zmk_sensor_delta_sent(&delta, &value);
+    zassert_false(zmk_sensor_delta_get(&delta, &value));
+}
+
+ZTEST_SUITE(sensor_delta, NULL, NULL, NULL, NULL, NULL);
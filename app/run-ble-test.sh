@@ -42,6 +42,30 @@ if [ -z "$BLE_TESTS_NO_CENTRAL_BUILD" ]; then
     fi
 
     cp build/tests/ble/no_auto_sec_central/zephyr/zephyr.exe "${BSIM_OUT_PATH}/bin/ble_test_no_auto_sec_central.exe"
+
+    if ! [ -e build/tests/ble/split_peripheral ]; then
+        west build -d build/tests/ble/split_peripheral -b nrf52_bsim tests/ble/split_peripheral > /dev/null 2>&1
+    else
+        west build -d build/tests/ble/split_peripheral
+    fi
+
+    cp build/tests/ble/split_peripheral/zephyr/zephyr.exe "${BSIM_OUT_PATH}/bin/ble_test_split_peripheral.exe"
+
+    if ! [ -e build/tests/ble/split_peripheral_reconnect ]; then
+        west build -d build/tests/ble/split_peripheral_reconnect -b nrf52_bsim tests/ble/split_peripheral -- -DCONFIG_ZMK_TEST_SPLIT_PERIPHERAL_RECONNECT=y -DCONFIG_BT_GATT_CACHING=y > /dev/null 2>&1
+    else
+        west build -d build/tests/ble/split_peripheral_reconnect
+    fi
+
+    cp build/tests/ble/split_peripheral_reconnect/zephyr/zephyr.exe "${BSIM_OUT_PATH}/bin/ble_test_split_peripheral_reconnect.exe"
+
+    if ! [ -e build/tests/ble/split_peripheral_invoke_behavior ]; then
+        west build -d build/tests/ble/split_peripheral_invoke_behavior -b nrf52_bsim tests/ble/split_peripheral -- -DCONFIG_ZMK_TEST_SPLIT_PERIPHERAL_INVOKE_BEHAVIOR=y > /dev/null 2>&1
+    else
+        west build -d build/tests/ble/split_peripheral_invoke_behavior
+    fi
+
+    cp build/tests/ble/split_peripheral_invoke_behavior/zephyr/zephyr.exe "${BSIM_OUT_PATH}/bin/ble_test_split_peripheral_invoke_behavior.exe"
 fi
 
 testcases=$(find $path -name nrf52_bsim.keymap -exec dirname \{\} \;)
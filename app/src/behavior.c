@@ -39,6 +39,122 @@ const struct device *z_impl_behavior_get_binding(const char *name) {
     return NULL;
 }
 
+/*
+ * Local IDs only cover behaviors that can be invoked on a split peripheral, i.e. the ones that
+ * aren't central-local. Central-local behaviors such as key presses and layers are only built into
+ * the central, so including them would make the central and peripheral tables differ. IDs are
+ * assigned in name order rather than section order, because the latter follows devicetree
+ * ordinals, which differ between the halves of a split keyboard.
+ *
+ * The behaviors with local IDs are sorted by name into the local ID slots once at boot, so an ID
+ * indexes its behavior directly and a name is found with a binary search.
+ */
+static size_t behavior_local_id_count;
+
+static bool behavior_has_local_id(const struct device *dev) {
+    enum behavior_locality locality;
+
+    return behavior_get_locality(dev, &locality) == 0 && locality != BEHAVIOR_LOCALITY_CENTRAL;
+}
+
+static struct zmk_behavior_local_id_slot *behavior_local_id_slot(size_t id) {
+    struct zmk_behavior_local_id_slot *slot;
+    STRUCT_SECTION_GET(zmk_behavior_local_id_slot, id, &slot);
+    return slot;
+}
+
+static int behavior_local_ids_init(void) {
+    size_t count = 0;
+
+    // Insertion sort, since there are only a few dozen behaviors and this runs once.
+    STRUCT_SECTION_FOREACH(zmk_behavior_ref, item) {
+        if (!behavior_has_local_id(item->device)) {
+            continue;
+        }
+
+        const char *name = item->device->name;
+        size_t id = count++;
+
+        while (id > 0 && strcmp(behavior_local_id_slot(id - 1)->device->name, name) > 0) {
+            behavior_local_id_slot(id)->device = behavior_local_id_slot(id - 1)->device;
+            id--;
+        }
+
+        behavior_local_id_slot(id)->device = item->device;
+    }
+
+    behavior_local_id_count = count;
+
+    return 0;
+}
+
+SYS_INIT(behavior_local_ids_init, PRE_KERNEL_1, 0);
+
+int zmk_behavior_get_local_id(const char *name) {
+    if (name == NULL || name[0] == '\0') {
+        return -EINVAL;
+    }
+
+    size_t low = 0;
+    size_t high = behavior_local_id_count;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const char *mid_name = behavior_local_id_slot(mid)->device->name;
+        int cmp = mid_name == name ? 0 : strcmp(mid_name, name);
+
+        if (cmp == 0) {
+            return mid;
+        } else if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return -ENODEV;
+}
+
+const struct device *zmk_behavior_get_binding_by_local_id(uint16_t id) {
+    if (id >= behavior_local_id_count) {
+        return NULL;
+    }
+
+    const struct device *dev = behavior_local_id_slot(id)->device;
+
+    return z_device_is_ready(dev) ? dev : NULL;
+}
+
+#define FNV_32_OFFSET_BASIS 0x811c9dc5U
+#define FNV_32_PRIME 0x01000193U
+
+uint32_t zmk_behavior_get_table_hash(void) {
+    static uint32_t hash;
+    static bool hash_valid;
+
+    if (hash_valid) {
+        return hash;
+    }
+
+    // Sum of the FNV-1a hashes of every name, including its terminator. Since IDs follow name
+    // order, the same set of names always yields the same IDs, whatever order they're visited in.
+    uint32_t value = 0;
+    for (size_t id = 0; id < behavior_local_id_count; id++) {
+        uint32_t name_hash = FNV_32_OFFSET_BASIS;
+        const char *name = behavior_local_id_slot(id)->device->name;
+        do {
+            name_hash = (name_hash ^ (uint8_t)*name) * FNV_32_PRIME;
+        } while (*name++ != '\0');
+
+        value += name_hash;
+    }
+
+    hash = value;
+    hash_valid = true;
+
+    return hash;
+}
+
 #if IS_ENABLED(CONFIG_LOG)
 static int check_behavior_names(void) {
     // Behavior names must be unique, but we don't have a good way to enforce this
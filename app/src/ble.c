@@ -37,6 +37,11 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/event_manager.h>
 #include <zmk/events/ble_active_profile_changed.h>
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAM_MANAGER)
+#include <zmk/events/activity_state_changed.h>
+#include <zmk/events/position_state_changed.h>
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAM_MANAGER) */
+
 #if IS_ENABLED(CONFIG_ZMK_BLE_PASSKEY_ENTRY)
 #include <zmk/events/keycode_state_changed.h>
 
@@ -76,11 +81,11 @@ static const struct bt_data zmk_ble_ad[] = {
                   ),
 };
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+#if ZMK_BLE_IS_CENTRAL
 
 static bt_addr_le_t peripheral_addrs[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
 
-#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL) */
+#endif /* ZMK_BLE_IS_CENTRAL */
 
 static void raise_profile_changed_event(void) {
     raise_zmk_ble_active_profile_changed((struct zmk_ble_active_profile_changed){
@@ -320,7 +325,7 @@ bt_addr_le_t *zmk_ble_active_profile_addr(void) { return &profiles[active_profil
 
 char *zmk_ble_active_profile_name(void) { return profiles[active_profile].name; }
 
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+#if ZMK_BLE_IS_CENTRAL
 
 int zmk_ble_put_peripheral_addr(const bt_addr_le_t *addr) {
     for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
@@ -357,7 +362,7 @@ int zmk_ble_put_peripheral_addr(const bt_addr_le_t *addr) {
     return -ENOMEM;
 }
 
-#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL) */
+#endif /* ZMK_BLE_IS_CENTRAL */
 
 #if IS_ENABLED(CONFIG_SETTINGS)
 
@@ -408,7 +413,7 @@ static int ble_profiles_handle_set(const char *name, size_t len, settings_read_c
             return err;
         }
     }
-#if IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+#if ZMK_BLE_IS_CENTRAL
     else if (settings_name_steq(name, "peripheral_addresses", &next) && next) {
         if (len != sizeof(bt_addr_le_t)) {
             return -EINVAL;
@@ -437,6 +442,188 @@ static bool is_conn_active_profile(const struct bt_conn *conn) {
     return bt_addr_le_cmp(bt_conn_get_dst(conn), &profiles[active_profile].peer) == 0;
 }
 
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAM_MANAGER)
+
+/*
+ * The connection to the active profile's host is switched between a fast parameter set while
+ * typing and a slow, high latency set once typing stops. Requests are rate limited, and the limit
+ * is doubled every time the host rejects or ignores a request.
+ */
+enum conn_param_profile {
+    CONN_PARAM_PROFILE_UNKNOWN,
+    CONN_PARAM_PROFILE_FAST,
+    CONN_PARAM_PROFILE_SLOW,
+};
+
+#define CONN_PARAM_MAX_BACKOFF_SHIFT 5
+
+static const struct bt_le_conn_param conn_param_profiles[] = {
+    [CONN_PARAM_PROFILE_FAST] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_BLE_CONN_PARAM_FAST_MIN_INT, CONFIG_ZMK_BLE_CONN_PARAM_FAST_MAX_INT,
+        CONFIG_ZMK_BLE_CONN_PARAM_FAST_LATENCY, CONFIG_ZMK_BLE_CONN_PARAM_FAST_TIMEOUT),
+    [CONN_PARAM_PROFILE_SLOW] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_BLE_CONN_PARAM_SLOW_MIN_INT, CONFIG_ZMK_BLE_CONN_PARAM_SLOW_MAX_INT,
+        CONFIG_ZMK_BLE_CONN_PARAM_SLOW_LATENCY, CONFIG_ZMK_BLE_CONN_PARAM_SLOW_TIMEOUT),
+};
+
+static enum conn_param_profile conn_param_desired = CONN_PARAM_PROFILE_SLOW;
+static enum conn_param_profile conn_param_requested = CONN_PARAM_PROFILE_UNKNOWN;
+static int64_t conn_param_last_request;
+static uint8_t conn_param_rejections;
+
+static enum conn_param_profile conn_param_profile_for(uint16_t interval, uint16_t latency) {
+    for (int i = CONN_PARAM_PROFILE_FAST; i < ARRAY_SIZE(conn_param_profiles); i++) {
+        const struct bt_le_conn_param *param = &conn_param_profiles[i];
+        if (interval >= param->interval_min && interval <= param->interval_max &&
+            latency == param->latency) {
+            return i;
+        }
+    }
+
+    return CONN_PARAM_PROFILE_UNKNOWN;
+}
+
+static int32_t conn_param_request_interval(void) {
+    return CONFIG_ZMK_BLE_CONN_PARAM_MIN_REQUEST_INTERVAL_MS
+           << MIN(conn_param_rejections, CONN_PARAM_MAX_BACKOFF_SHIFT);
+}
+
+static void conn_param_update_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(conn_param_update_work, conn_param_update_callback);
+
+static void conn_param_update_callback(struct k_work *work) {
+    struct bt_conn *conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, zmk_ble_active_profile_addr());
+    if (conn == NULL) {
+        return;
+    }
+
+    struct bt_conn_info info;
+    bt_conn_get_info(conn, &info);
+
+    if (info.role != BT_CONN_ROLE_PERIPHERAL || info.state != BT_CONN_STATE_CONNECTED ||
+        conn_param_profile_for(info.le.interval, info.le.latency) == conn_param_desired) {
+        bt_conn_unref(conn);
+        return;
+    }
+
+    int64_t wait = conn_param_last_request + conn_param_request_interval() - k_uptime_get();
+    if (wait > 0) {
+        k_work_reschedule(&conn_param_update_work, K_MSEC(wait));
+        bt_conn_unref(conn);
+        return;
+    }
+
+    if (conn_param_requested == conn_param_desired) {
+        LOG_DBG("Host did not apply the requested connection parameters");
+        conn_param_rejections++;
+    }
+
+    const struct bt_le_conn_param *param = &conn_param_profiles[conn_param_desired];
+    LOG_DBG("Requesting %s connection parameters: interval %d-%d latency %d timeout %d",
+            conn_param_desired == CONN_PARAM_PROFILE_FAST ? "fast" : "slow", param->interval_min,
+            param->interval_max, param->latency, param->timeout);
+
+    int err = bt_conn_le_param_update(conn, param);
+    if (err) {
+        LOG_WRN("Failed to request connection parameter update (err %d)", err);
+    }
+
+    conn_param_requested = conn_param_desired;
+    conn_param_last_request = k_uptime_get();
+    k_work_reschedule(&conn_param_update_work, K_MSEC(conn_param_request_interval()));
+
+    bt_conn_unref(conn);
+}
+
+static void conn_param_set_desired(enum conn_param_profile profile) {
+    if (conn_param_desired == profile) {
+        return;
+    }
+
+    conn_param_desired = profile;
+    k_work_reschedule(&conn_param_update_work, K_NO_WAIT);
+}
+
+static void conn_param_hold_expired(struct k_work *work) {
+    conn_param_set_desired(CONN_PARAM_PROFILE_SLOW);
+}
+
+static K_WORK_DELAYABLE_DEFINE(conn_param_hold_work, conn_param_hold_expired);
+
+static void conn_param_note_activity(void) {
+    conn_param_set_desired(CONN_PARAM_PROFILE_FAST);
+    k_work_reschedule(&conn_param_hold_work, K_MSEC(CONFIG_ZMK_BLE_CONN_PARAM_FAST_HOLD_MS));
+}
+
+static void conn_param_reset(void) {
+    conn_param_requested = CONN_PARAM_PROFILE_UNKNOWN;
+    conn_param_rejections = 0;
+    // Give the host some time to finish setting up the connection before the first request.
+    conn_param_last_request = k_uptime_get();
+    k_work_reschedule(&conn_param_update_work, K_NO_WAIT);
+}
+
+static void conn_param_disconnected(void) {
+    // Forget what was negotiated with the host, so a reconnect on the same profile starts from a
+    // clean slate instead of inheriting stale requests and back-off.
+    k_work_cancel_delayable(&conn_param_update_work);
+    conn_param_requested = CONN_PARAM_PROFILE_UNKNOWN;
+    conn_param_rejections = 0;
+}
+
+static void conn_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency) {
+    if (!is_conn_active_profile(conn) || conn_param_requested == CONN_PARAM_PROFILE_UNKNOWN) {
+        return;
+    }
+
+    if (conn_param_profile_for(interval, latency) == conn_param_requested) {
+        conn_param_rejections = 0;
+    } else {
+        LOG_DBG("Host applied different connection parameters than requested");
+        conn_param_rejections++;
+    }
+
+    conn_param_requested = CONN_PARAM_PROFILE_UNKNOWN;
+    k_work_reschedule(&conn_param_update_work, K_NO_WAIT);
+}
+
+static int conn_param_listener(const zmk_event_t *eh) {
+    const struct zmk_activity_state_changed *activity_ev = as_zmk_activity_state_changed(eh);
+    if (activity_ev != NULL) {
+        if (activity_ev->state == ZMK_ACTIVITY_ACTIVE) {
+            conn_param_note_activity();
+        } else {
+            k_work_cancel_delayable(&conn_param_hold_work);
+            conn_param_set_desired(CONN_PARAM_PROFILE_SLOW);
+        }
+
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    const struct zmk_position_state_changed *position_ev = as_zmk_position_state_changed(eh);
+    if (position_ev != NULL) {
+        if (position_ev->state) {
+            conn_param_note_activity();
+        }
+
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    if (as_zmk_ble_active_profile_changed(eh) != NULL) {
+        conn_param_reset();
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(zmk_ble_conn_param, conn_param_listener);
+ZMK_SUBSCRIPTION(zmk_ble_conn_param, zmk_activity_state_changed);
+ZMK_SUBSCRIPTION(zmk_ble_conn_param, zmk_position_state_changed);
+ZMK_SUBSCRIPTION(zmk_ble_conn_param, zmk_ble_active_profile_changed);
+
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAM_MANAGER) */
+
 static void connected(struct bt_conn *conn, uint8_t err) {
     char addr[BT_ADDR_LE_STR_LEN];
     struct bt_conn_info info;
@@ -489,12 +676,34 @@ static void disconnected(struct bt_conn *conn, uint8_t reason) {
 
     if (is_conn_active_profile(conn)) {
         LOG_DBG("Active profile disconnected");
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAM_MANAGER)
+        conn_param_disconnected();
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAM_MANAGER) */
         k_work_submit(&raise_profile_changed_event_work);
     }
 }
 
+void zmk_ble_request_link_upgrade(struct bt_conn *conn) {
+#if IS_ENABLED(CONFIG_ZMK_BLE_PREFER_2M_PHY)
+    // If the peer doesn't support or rejects the 2M PHY, the link simply stays on its current PHY.
+    int phy_err = bt_conn_le_phy_update(conn, BT_CONN_LE_PHY_PARAM_2M);
+    if (phy_err) {
+        LOG_WRN("Failed to request 2M PHY, staying on current PHY (err %d)", phy_err);
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_PREFER_2M_PHY) */
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_DATA_LENGTH_EXTENSION)
+    int data_len_err = bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX);
+    if (data_len_err) {
+        LOG_WRN("Failed to request data length update, staying on current length (err %d)",
+                data_len_err);
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_DATA_LENGTH_EXTENSION) */
+}
+
 static void security_changed(struct bt_conn *conn, bt_security_t level, enum bt_security_err err) {
     char addr[BT_ADDR_LE_STR_LEN];
+    struct bt_conn_info info;
 
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
 
@@ -502,16 +711,71 @@ static void security_changed(struct bt_conn *conn, bt_security_t level, enum bt_
         LOG_DBG("Security changed: %s level %u", addr, level);
     } else {
         LOG_ERR("Security failed: %s level %u err %d", addr, level, err);
+        return;
+    }
+
+    bt_conn_get_info(conn, &info);
+
+    // On a split peripheral, our only connection is the split link, whose upgrade is requested by
+    // the central. Both ends initiating would race the two procedures against each other.
+    if (IS_ENABLED(CONFIG_ZMK_SPLIT) && !IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)) {
+        return;
+    }
+
+    if (info.role == BT_CONN_ROLE_PERIPHERAL) {
+        zmk_ble_request_link_upgrade(conn);
     }
 }
 
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+
+static void le_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param) {
+    char addr[BT_ADDR_LE_STR_LEN];
+
+    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
+
+    LOG_DBG("%s: PHY tx %d rx %d", addr, param->tx_phy, param->rx_phy);
+
+    if (IS_ENABLED(CONFIG_ZMK_BLE_PREFER_2M_PHY) && param->tx_phy != BT_GAP_LE_PHY_2M) {
+        LOG_DBG("%s: peer did not accept the 2M PHY, staying on PHY %d", addr, param->tx_phy);
+    }
+}
+
+#endif /* IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE) */
+
+#if IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE)
+
+static void le_data_len_updated(struct bt_conn *conn, struct bt_conn_le_data_len_info *info) {
+    char addr[BT_ADDR_LE_STR_LEN];
+
+    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
+
+    LOG_DBG("%s: data length tx %d (%dus) rx %d (%dus)", addr, info->tx_max_len,
+            info->tx_max_time, info->rx_max_len, info->rx_max_time);
+}
+
+#endif /* IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE) */
+
 static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
                              uint16_t timeout) {
     char addr[BT_ADDR_LE_STR_LEN];
 
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
 
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+    struct bt_conn_info info;
+
+    bt_conn_get_info(conn, &info);
+
+    LOG_DBG("%s: interval %d latency %d timeout %d, PHY tx %d rx %d", addr, interval, latency,
+            timeout, info.le.phy->tx_phy, info.le.phy->rx_phy);
+#else
     LOG_DBG("%s: interval %d latency %d timeout %d", addr, interval, latency, timeout);
+#endif /* IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE) */
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAM_MANAGER)
+    conn_param_updated(conn, interval, latency);
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAM_MANAGER) */
 }
 
 static struct bt_conn_cb conn_callbacks = {
@@ -519,6 +783,12 @@ static struct bt_conn_cb conn_callbacks = {
     .disconnected = disconnected,
     .security_changed = security_changed,
     .le_param_updated = le_param_updated,
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+    .le_phy_updated = le_phy_updated,
+#endif /* IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE) */
+#if IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE)
+    .le_data_len_updated = le_data_len_updated,
+#endif /* IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE) */
 };
 
 /*
@@ -6,6 +6,10 @@
 
 #include <zephyr/settings/settings.h>
 #include <zephyr/init.h>
+#include <zephyr/spinlock.h>
+#if IS_ENABLED(CONFIG_TRACING)
+#include <zephyr/tracing/tracing.h>
+#endif // IS_ENABLED(CONFIG_TRACING)
 
 #include <zephyr/logging/log.h>
 
@@ -15,6 +19,8 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zephyr/bluetooth/gatt.h>
 
 #include <zmk/ble.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/ble_active_profile_changed.h>
 #include <zmk/endpoints_types.h>
 #include <zmk/hog.h>
 #include <zmk/hid.h>
@@ -239,166 +245,692 @@ K_THREAD_STACK_DEFINE(hog_q_stack, CONFIG_ZMK_BLE_THREAD_STACK_SIZE);
 
 struct k_work_q hog_work_q;
 
-K_MSGQ_DEFINE(zmk_hog_keyboard_msgq, sizeof(struct zmk_hid_keyboard_report_body),
-              CONFIG_ZMK_BLE_KEYBOARD_REPORT_QUEUE_SIZE, 4);
+static void hog_send_callback(struct k_work *work);
 
-void send_keyboard_report_callback(struct k_work *work) {
-    struct zmk_hid_keyboard_report_body report;
+K_WORK_DEFINE(hog_send_work, hog_send_callback);
 
-    while (k_msgq_get(&zmk_hog_keyboard_msgq, &report, K_NO_WAIT) == 0) {
-        struct bt_conn *conn = destination_connection();
-        if (conn == NULL) {
-            return;
+/*
+ * Reports waiting to be notified are held in small coalescing queues. When a new report arrives at
+ * a full queue, two adjacent queued reports are merged as long as that doesn't hide a transition,
+ * i.e. no bit that flipped between the previous report and the first one flips back in the second.
+ * Press and release edges are therefore always delivered, while intermediate states are only
+ * collapsed under radio congestion.
+ */
+typedef bool (*hog_report_merge_t)(const void *prev, void *tail, const void *next, bool force);
+
+struct hog_report_queue {
+    struct k_mutex lock;
+    struct k_sem space;
+    uint8_t *reports;
+    uint8_t *last_sent;
+    const size_t report_size;
+    const size_t capacity;
+    const hog_report_merge_t merge;
+    size_t head;
+    size_t count;
+    struct zmk_hog_queue_stats stats;
+    // Reports have been merged since the queue was last empty.
+    bool congested;
+};
+
+#define HOG_REPORT_QUEUE_DEFINE(name, type, size, merge_fn)                                        \
+    static type name##_reports[size];                                                              \
+    static type name##_last_sent;                                                                  \
+    static struct hog_report_queue name = {                                                        \
+        .reports = (uint8_t *)name##_reports,                                                      \
+        .last_sent = (uint8_t *)&name##_last_sent,                                                 \
+        .report_size = sizeof(type),                                                               \
+        .capacity = size,                                                                          \
+        .merge = merge_fn,                                                                         \
+    }
+
+static uint8_t *hog_report_queue_at(struct hog_report_queue *queue, size_t index) {
+    return queue->reports + ((queue->head + index) % queue->capacity) * queue->report_size;
+}
+
+static const uint8_t *hog_report_queue_prev(struct hog_report_queue *queue, size_t index) {
+    return index == 0 ? queue->last_sent : hog_report_queue_at(queue, index - 1);
+}
+
+static void hog_report_queue_remove(struct hog_report_queue *queue, size_t index) {
+    for (size_t i = index; i + 1 < queue->count; i++) {
+        memcpy(hog_report_queue_at(queue, i), hog_report_queue_at(queue, i + 1),
+               queue->report_size);
+    }
+
+    queue->count--;
+}
+
+// Merges one queued report into its successor, making room for a new report. Must be called
+// with the queue lock held.
+static bool hog_report_queue_compact(struct hog_report_queue *queue) {
+    for (size_t i = 0; i + 1 < queue->count; i++) {
+        if (queue->merge(hog_report_queue_prev(queue, i), hog_report_queue_at(queue, i),
+                         hog_report_queue_at(queue, i + 1), false)) {
+            hog_report_queue_remove(queue, i + 1);
+            queue->stats.merged++;
+            queue->congested = true;
+            return true;
         }
+    }
+
+    return false;
+}
 
-        struct bt_gatt_notify_params notify_params = {
-            .attr = &hog_svc.attrs[5],
-            .data = &report,
-            .len = sizeof(report),
-        };
-
-        int err = bt_gatt_notify_cb(conn, &notify_params);
-        if (err == -EPERM) {
-            bt_conn_set_security(conn, BT_SECURITY_L2);
-        } else if (err) {
-            LOG_DBG("Error notifying %d", err);
+static bool hog_report_queue_try_put(struct hog_report_queue *queue, const void *report,
+                                     bool force) {
+    // Reports are only merged once the queue is full. Merging any earlier would collapse reports
+    // the radio still has room for, such as the steps of a fast roll from {} to {A} to {A,B},
+    // which the host then sees as both keys pressed at once.
+    if (queue->count == queue->capacity && !hog_report_queue_compact(queue)) {
+        if (!force) {
+            return false;
         }
 
-        bt_conn_unref(conn);
+        // Out of room and time: fold the report into the tail anyway so the host still ends up
+        // with the latest state, at the cost of the transitions hidden by the merge.
+        LOG_WRN("Report queue still full, merging report and dropping its transitions");
+        size_t tail = queue->count - 1;
+        queue->merge(hog_report_queue_prev(queue, tail), hog_report_queue_at(queue, tail), report,
+                     true);
+        queue->stats.dropped++;
+        queue->congested = true;
+        return true;
     }
+
+    memcpy(hog_report_queue_at(queue, queue->count), report, queue->report_size);
+    queue->count++;
+    queue->stats.max_depth = MAX(queue->stats.max_depth, queue->count);
+    return true;
 }
 
-K_WORK_DEFINE(hog_keyboard_work, send_keyboard_report_callback);
+static int hog_report_queue_put(struct hog_report_queue *queue, const void *report) {
+    int64_t deadline = k_uptime_get() + CONFIG_ZMK_BLE_REPORT_QUEUE_FULL_TIMEOUT_MS;
 
-int zmk_hog_send_keyboard_report(struct zmk_hid_keyboard_report_body *report) {
-    int err = k_msgq_put(&zmk_hog_keyboard_msgq, report, K_MSEC(100));
-    if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("Keyboard message queue full, popping first message and queueing again");
-            struct zmk_hid_keyboard_report_body discarded_report;
-            k_msgq_get(&zmk_hog_keyboard_msgq, &discarded_report, K_NO_WAIT);
-            return zmk_hog_send_keyboard_report(report);
+    while (true) {
+        k_mutex_lock(&queue->lock, K_FOREVER);
+        int64_t remaining = deadline - k_uptime_get();
+        bool queued = hog_report_queue_try_put(queue, report, remaining <= 0);
+        k_mutex_unlock(&queue->lock);
+
+        if (queued) {
+            return 0;
         }
-        default:
-            LOG_WRN("Failed to queue keyboard report to send (%d)", err);
-            return err;
+
+        k_sem_take(&queue->space, K_MSEC(remaining));
+    }
+}
+
+static bool hog_report_queue_get(struct hog_report_queue *queue, void *report) {
+    k_mutex_lock(&queue->lock, K_FOREVER);
+
+    if (queue->count == 0) {
+        k_mutex_unlock(&queue->lock);
+        return false;
+    }
+
+    memcpy(report, hog_report_queue_at(queue, 0), queue->report_size);
+    memcpy(queue->last_sent, report, queue->report_size);
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+
+    bool drained_congestion = queue->count == 0 && queue->congested;
+    struct zmk_hog_queue_stats stats = queue->stats;
+    if (drained_congestion) {
+        queue->congested = false;
+    }
+
+    k_mutex_unlock(&queue->lock);
+    k_sem_give(&queue->space);
+
+    if (drained_congestion) {
+        LOG_DBG("Report queue drained after merging reports, max depth %u, merged %u, dropped %u",
+                stats.max_depth, stats.merged, stats.dropped);
+    }
+
+    return true;
+}
+
+// Discards every queued report, e.g. while there is no host to send them to. The next report is
+// then compared against an empty one, which is the state a newly connected host starts from.
+static void hog_report_queue_purge(struct hog_report_queue *queue) {
+    k_mutex_lock(&queue->lock, K_FOREVER);
+    queue->head = 0;
+    queue->count = 0;
+    queue->congested = false;
+    memset(queue->last_sent, 0, queue->report_size);
+    k_mutex_unlock(&queue->lock);
+    k_sem_give(&queue->space);
+}
+
+static size_t hog_report_queue_depth(struct hog_report_queue *queue) {
+    k_mutex_lock(&queue->lock, K_FOREVER);
+    size_t depth = queue->count;
+    k_mutex_unlock(&queue->lock);
+
+    return depth;
+}
+
+static void hog_report_queue_get_stats(struct hog_report_queue *queue,
+                                       struct zmk_hog_queue_stats *stats) {
+    k_mutex_lock(&queue->lock, K_FOREVER);
+    *stats = queue->stats;
+    stats->depth = queue->count;
+    k_mutex_unlock(&queue->lock);
+}
+
+static void hog_report_queue_init(struct hog_report_queue *queue) {
+    k_mutex_init(&queue->lock);
+    k_sem_init(&queue->space, 0, 1);
+}
+
+// Bits that changed from prev to tail must not change back from tail to next.
+static bool hog_bits_mergeable(uint8_t prev, uint8_t tail, uint8_t next) {
+    return ((prev ^ tail) & (tail ^ next)) == 0;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
+
+static bool keyboard_report_has_key(const struct zmk_hid_keyboard_report_body *body,
+                                    uint8_t key) {
+    for (int i = 0; i < ARRAY_SIZE(body->keys); i++) {
+        if (body->keys[i] == key) {
+            return true;
         }
     }
 
-    k_work_submit_to_queue(&hog_work_q, &hog_keyboard_work);
+    return false;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
+
+static bool keyboard_report_merge(const void *prev_report, void *tail_report,
+                                  const void *next_report, bool force) {
+    const struct zmk_hid_keyboard_report_body *prev = prev_report;
+    struct zmk_hid_keyboard_report_body *tail = tail_report;
+    const struct zmk_hid_keyboard_report_body *next = next_report;
+
+    if (!force) {
+        if (!hog_bits_mergeable(prev->modifiers, tail->modifiers, next->modifiers)) {
+            return false;
+        }
+
+#if IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_NKRO)
+        for (int i = 0; i < ARRAY_SIZE(tail->keys); i++) {
+            if (!hog_bits_mergeable(prev->keys[i], tail->keys[i], next->keys[i])) {
+                return false;
+            }
+        }
+#elif IS_ENABLED(CONFIG_ZMK_HID_REPORT_TYPE_HKRO)
+        for (int i = 0; i < ARRAY_SIZE(tail->keys); i++) {
+            // A press that would be released again before the host sees it.
+            if (tail->keys[i] != 0 && !keyboard_report_has_key(prev, tail->keys[i]) &&
+                !keyboard_report_has_key(next, tail->keys[i])) {
+                return false;
+            }
+
+            // A release that would be pressed again before the host sees it.
+            if (prev->keys[i] != 0 && !keyboard_report_has_key(tail, prev->keys[i]) &&
+                keyboard_report_has_key(next, prev->keys[i])) {
+                return false;
+            }
+        }
+#endif
+    }
+
+    memcpy(tail, next, sizeof(*tail));
+    return true;
+}
+
+HOG_REPORT_QUEUE_DEFINE(keyboard_queue, struct zmk_hid_keyboard_report_body,
+                        CONFIG_ZMK_BLE_KEYBOARD_REPORT_QUEUE_SIZE, keyboard_report_merge);
+
+int zmk_hog_send_keyboard_report(struct zmk_hid_keyboard_report_body *report) {
+    int err = hog_report_queue_put(&keyboard_queue, report);
+    if (err) {
+        LOG_WRN("Failed to queue keyboard report to send (%d)", err);
+        return err;
+    }
+
+    k_work_submit_to_queue(&hog_work_q, &hog_send_work);
 
     return 0;
 };
 
-K_MSGQ_DEFINE(zmk_hog_consumer_msgq, sizeof(struct zmk_hid_consumer_report_body),
-              CONFIG_ZMK_BLE_CONSUMER_REPORT_QUEUE_SIZE, 4);
-
-void send_consumer_report_callback(struct k_work *work) {
-    struct zmk_hid_consumer_report_body report;
+void zmk_hog_get_keyboard_queue_stats(struct zmk_hog_queue_stats *stats) {
+    hog_report_queue_get_stats(&keyboard_queue, stats);
+}
 
-    while (k_msgq_get(&zmk_hog_consumer_msgq, &report, K_NO_WAIT) == 0) {
-        struct bt_conn *conn = destination_connection();
-        if (conn == NULL) {
-            return;
+static bool consumer_report_has_usage(const struct zmk_hid_consumer_report_body *body,
+                                      uint16_t usage) {
+    for (int i = 0; i < ARRAY_SIZE(body->keys); i++) {
+        if (body->keys[i] == usage) {
+            return true;
         }
+    }
+
+    return false;
+}
 
-        struct bt_gatt_notify_params notify_params = {
-            .attr = &hog_svc.attrs[9],
-            .data = &report,
-            .len = sizeof(report),
-        };
-
-        int err = bt_gatt_notify_cb(conn, &notify_params);
-        if (err == -EPERM) {
-            bt_conn_set_security(conn, BT_SECURITY_L2);
-        } else if (err) {
-            LOG_DBG("Error notifying %d", err);
+static bool consumer_report_merge(const void *prev_report, void *tail_report,
+                                  const void *next_report, bool force) {
+    const struct zmk_hid_consumer_report_body *prev = prev_report;
+    struct zmk_hid_consumer_report_body *tail = tail_report;
+    const struct zmk_hid_consumer_report_body *next = next_report;
+
+    for (int i = 0; i < ARRAY_SIZE(tail->keys) && !force; i++) {
+        if (tail->keys[i] != 0 && !consumer_report_has_usage(prev, tail->keys[i]) &&
+            !consumer_report_has_usage(next, tail->keys[i])) {
+            return false;
         }
 
-        bt_conn_unref(conn);
+        if (prev->keys[i] != 0 && !consumer_report_has_usage(tail, prev->keys[i]) &&
+            consumer_report_has_usage(next, prev->keys[i])) {
+            return false;
+        }
     }
-};
 
-K_WORK_DEFINE(hog_consumer_work, send_consumer_report_callback);
+    memcpy(tail, next, sizeof(*tail));
+    return true;
+}
+
+HOG_REPORT_QUEUE_DEFINE(consumer_queue, struct zmk_hid_consumer_report_body,
+                        CONFIG_ZMK_BLE_CONSUMER_REPORT_QUEUE_SIZE, consumer_report_merge);
 
 int zmk_hog_send_consumer_report(struct zmk_hid_consumer_report_body *report) {
-    int err = k_msgq_put(&zmk_hog_consumer_msgq, report, K_MSEC(100));
+    int err = hog_report_queue_put(&consumer_queue, report);
     if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("Consumer message queue full, popping first message and queueing again");
-            struct zmk_hid_consumer_report_body discarded_report;
-            k_msgq_get(&zmk_hog_consumer_msgq, &discarded_report, K_NO_WAIT);
-            return zmk_hog_send_consumer_report(report);
-        }
-        default:
-            LOG_WRN("Failed to queue consumer report to send (%d)", err);
-            return err;
-        }
+        LOG_WRN("Failed to queue consumer report to send (%d)", err);
+        return err;
     }
 
-    k_work_submit_to_queue(&hog_work_q, &hog_consumer_work);
+    k_work_submit_to_queue(&hog_work_q, &hog_send_work);
 
     return 0;
 };
 
+void zmk_hog_get_consumer_queue_stats(struct zmk_hog_queue_stats *stats) {
+    hog_report_queue_get_stats(&consumer_queue, stats);
+}
+
 #if IS_ENABLED(CONFIG_ZMK_MOUSE)
 
-K_MSGQ_DEFINE(zmk_hog_mouse_msgq, sizeof(struct zmk_hid_mouse_report_body),
-              CONFIG_ZMK_BLE_MOUSE_REPORT_QUEUE_SIZE, 4);
+static bool mouse_delta_add(int8_t *total, int8_t delta, bool force) {
+    int16_t sum = *total + delta;
+    if (!force && (sum > INT8_MAX || sum < -INT8_MAX)) {
+        return false;
+    }
 
-void send_mouse_report_callback(struct k_work *work) {
-    struct zmk_hid_mouse_report_body report;
-    while (k_msgq_get(&zmk_hog_mouse_msgq, &report, K_NO_WAIT) == 0) {
-        struct bt_conn *conn = destination_connection();
-        if (conn == NULL) {
-            return;
-        }
+    *total = CLAMP(sum, -INT8_MAX, INT8_MAX);
+    return true;
+}
 
-        struct bt_gatt_notify_params notify_params = {
-            .attr = &hog_svc.attrs[13],
-            .data = &report,
-            .len = sizeof(report),
-        };
-
-        int err = bt_gatt_notify_cb(conn, &notify_params);
-        if (err == -EPERM) {
-            bt_conn_set_security(conn, BT_SECURITY_L2);
-        } else if (err) {
-            LOG_DBG("Error notifying %d", err);
-        }
+static bool mouse_report_merge(const void *prev_report, void *tail_report, const void *next_report,
+                               bool force) {
+    const struct zmk_hid_mouse_report_body *prev = prev_report;
+    struct zmk_hid_mouse_report_body *tail = tail_report;
+    const struct zmk_hid_mouse_report_body *next = next_report;
 
-        bt_conn_unref(conn);
+    if (!force && !hog_bits_mergeable(prev->buttons, tail->buttons, next->buttons)) {
+        return false;
+    }
+
+    struct zmk_hid_mouse_report_body merged = *tail;
+    if (!mouse_delta_add(&merged.d_x, next->d_x, force) ||
+        !mouse_delta_add(&merged.d_y, next->d_y, force) ||
+        !mouse_delta_add(&merged.d_wheel, next->d_wheel, force)) {
+        return false;
     }
-};
 
-K_WORK_DEFINE(hog_mouse_work, send_mouse_report_callback);
+    merged.buttons = next->buttons;
+    *tail = merged;
+    return true;
+}
+
+HOG_REPORT_QUEUE_DEFINE(mouse_queue, struct zmk_hid_mouse_report_body,
+                        CONFIG_ZMK_BLE_MOUSE_REPORT_QUEUE_SIZE, mouse_report_merge);
 
 int zmk_hog_send_mouse_report(struct zmk_hid_mouse_report_body *report) {
-    int err = k_msgq_put(&zmk_hog_mouse_msgq, report, K_MSEC(100));
+    int err = hog_report_queue_put(&mouse_queue, report);
     if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("Consumer message queue full, popping first message and queueing again");
-            struct zmk_hid_mouse_report_body discarded_report;
-            k_msgq_get(&zmk_hog_mouse_msgq, &discarded_report, K_NO_WAIT);
-            return zmk_hog_send_mouse_report(report);
+        LOG_WRN("Failed to queue mouse report to send (%d)", err);
+        return err;
+    }
+
+    k_work_submit_to_queue(&hog_work_q, &hog_send_work);
+
+    return 0;
+};
+
+void zmk_hog_get_mouse_queue_stats(struct zmk_hog_queue_stats *stats) {
+    hog_report_queue_get_stats(&mouse_queue, stats);
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+/*
+ * All report types are sent from a single work item, so one pass over the queues can hand
+ * several notifications to the stack back to back and have them go out in the same connection
+ * event. The number of notifications handed to the stack but not yet sent is bounded by credits
+ * that are returned from the notify complete callback, which also kicks off the next pass.
+ */
+union hog_report {
+    struct zmk_hid_keyboard_report_body keyboard;
+    struct zmk_hid_consumer_report_body consumer;
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    struct zmk_hid_mouse_report_body mouse;
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+};
+
+struct hog_report_source {
+    struct hog_report_queue *queue;
+    const struct bt_gatt_attr *attr;
+    // Reports that may be held back until just before the next connection event.
+    bool deferrable;
+};
+
+static const struct hog_report_source hog_report_sources[] = {
+    {.queue = &keyboard_queue, .attr = &hog_svc.attrs[5]},
+    {.queue = &consumer_queue, .attr = &hog_svc.attrs[9], .deferrable = true},
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    {.queue = &mouse_queue, .attr = &hog_svc.attrs[13], .deferrable = true},
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+};
+
+static K_SEM_DEFINE(hog_notify_credits, CONFIG_ZMK_BLE_MAX_PENDING_NOTIFICATIONS,
+                    CONFIG_ZMK_BLE_MAX_PENDING_NOTIFICATIONS);
+
+// The stack doesn't call hog_notify_complete for notifications still pending when their link
+// drops, so their credits are returned once the host link goes away or changes. Callbacks that do
+// arrive late are harmless, since the semaphore can't count past its limit.
+static void hog_notify_credits_reset(void) {
+    for (int i = 0; i < CONFIG_ZMK_BLE_MAX_PENDING_NOTIFICATIONS; i++) {
+        k_sem_give(&hog_notify_credits);
+    }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+
+/*
+ * The notify complete callback runs once the controller reports a packet as sent, which happens
+ * at the end of a connection event, so its timestamps track the connection event anchor plus a
+ * roughly constant processing delay. Keyboard reports are always handed to the stack right away,
+ * ahead of any other report type. Mouse and consumer reports are instead held back until just
+ * before the next predicted connection event, so that anything arriving in the meantime is merged
+ * into them rather than costing another notification, without adding latency.
+ */
+static struct k_spinlock conn_event_lock;
+static int64_t conn_event_anchor_ticks;
+static uint32_t conn_event_interval_us;
+
+static void hog_deferred_send_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(hog_deferred_send_work, hog_deferred_send_callback);
+
+static atomic_t hog_deferred_send_due;
+
+static void hog_deferred_send_callback(struct k_work *work) {
+    atomic_set(&hog_deferred_send_due, true);
+    k_work_submit_to_queue(&hog_work_q, &hog_send_work);
+}
+
+static void hog_conn_event_track(struct bt_conn *conn) {
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(conn, &info) != 0) {
+        return;
+    }
+
+    int64_t now = k_uptime_ticks();
+    uint32_t interval_us = info.le.interval * 1250;
+    bool measured = false;
+    int32_t jitter_us = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&conn_event_lock);
+
+    if (conn_event_anchor_ticks != 0 && conn_event_interval_us == interval_us) {
+        // Offset from the nearest predicted connection event, in (-interval/2, interval/2].
+        jitter_us = k_ticks_to_us_near64(now - conn_event_anchor_ticks) % interval_us;
+        if (jitter_us > (int32_t)(interval_us / 2)) {
+            jitter_us -= (int32_t)interval_us;
         }
-        default:
-            LOG_WRN("Failed to queue mouse report to send (%d)", err);
-            return err;
+        measured = true;
+    }
+
+    conn_event_anchor_ticks = now;
+    conn_event_interval_us = interval_us;
+
+    k_spin_unlock(&conn_event_lock, key);
+
+    if (!measured) {
+        return;
+    }
+
+    LOG_DBG("Connection event jitter %d us (interval %u us)", jitter_us, interval_us);
+
+#if IS_ENABLED(CONFIG_TRACING)
+    sys_trace_named_event("zmk_hog_conn_event_jitter", (uint32_t)jitter_us, interval_us);
+#endif // IS_ENABLED(CONFIG_TRACING)
+}
+
+// Forgets the tracked connection event timing, e.g. once the link is gone or its parameters have
+// changed and the old anchor no longer predicts anything. Deferrable reports are then sent right
+// away until the next notify complete callback measures a fresh anchor.
+static void hog_conn_event_reset(void) {
+    k_spinlock_key_t key = k_spin_lock(&conn_event_lock);
+    conn_event_anchor_ticks = 0;
+    conn_event_interval_us = 0;
+    k_spin_unlock(&conn_event_lock, key);
+}
+
+// Returns how long deferrable reports should still be held back, or K_NO_WAIT if they are
+// due now or no connection event timing is known yet.
+static k_timeout_t hog_conn_event_deferral(void) {
+    k_spinlock_key_t key = k_spin_lock(&conn_event_lock);
+    int64_t anchor = conn_event_anchor_ticks;
+    uint32_t interval_us = conn_event_interval_us;
+    k_spin_unlock(&conn_event_lock, key);
+
+    if (anchor == 0 || interval_us == 0) {
+        return K_NO_WAIT;
+    }
+
+    uint32_t since_anchor_us = k_ticks_to_us_near64(k_uptime_ticks() - anchor) % interval_us;
+    uint32_t until_event_us = interval_us - since_anchor_us;
+
+    if (until_event_us <= CONFIG_ZMK_BLE_CONN_EVENT_LEAD_US) {
+        return K_NO_WAIT;
+    }
+
+    return K_USEC(until_event_us - CONFIG_ZMK_BLE_CONN_EVENT_LEAD_US);
+}
+
+// Decides whether this pass should send deferrable reports, scheduling a later pass if not.
+static bool hog_deferred_reports_due(void) {
+    if (atomic_get(&hog_deferred_send_due)) {
+        return true;
+    }
+
+    k_timeout_t delay = hog_conn_event_deferral();
+    if (K_TIMEOUT_EQ(delay, K_NO_WAIT)) {
+        return true;
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(hog_report_sources); i++) {
+        const struct hog_report_source *source = &hog_report_sources[i];
+        size_t depth = source->deferrable ? hog_report_queue_depth(source->queue) : 0;
+
+        // Never keep a full queue waiting, that would stall whoever is queueing reports.
+        if (depth == source->queue->capacity) {
+            return true;
         }
+
+        if (depth > 0) {
+            // Has no effect if a pass is already scheduled.
+            k_work_schedule_for_queue(&hog_work_q, &hog_deferred_send_work, delay);
+        }
+    }
+
+    return false;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+
+static void hog_notify_complete(struct bt_conn *conn, void *user_data) {
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+    hog_conn_event_track(conn);
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+
+    k_sem_give(&hog_notify_credits);
+    k_work_submit_to_queue(&hog_work_q, &hog_send_work);
+}
+
+// Notifies the next queued report from the given source. Returns -EBUSY if the stack has no
+// room for more notifications, or -ENODATA if nothing is queued.
+static int hog_send_next_report(struct bt_conn *conn, const struct hog_report_source *source) {
+    union hog_report report;
+
+    if (k_sem_take(&hog_notify_credits, K_NO_WAIT) != 0) {
+        return -EBUSY;
+    }
+
+    if (!hog_report_queue_get(source->queue, &report)) {
+        k_sem_give(&hog_notify_credits);
+        return -ENODATA;
     }
 
-    k_work_submit_to_queue(&hog_work_q, &hog_mouse_work);
+    struct bt_gatt_notify_params notify_params = {
+        .attr = source->attr,
+        .data = &report,
+        .len = source->queue->report_size,
+        .func = hog_notify_complete,
+    };
+
+    int err = bt_gatt_notify_cb(conn, &notify_params);
+    if (err) {
+        k_sem_give(&hog_notify_credits);
+    }
+
+    if (err == -EPERM) {
+        bt_conn_set_security(conn, BT_SECURITY_L2);
+    } else if (err) {
+        LOG_DBG("Error notifying %d", err);
+    }
 
     return 0;
+}
+
+// Drops the reports queued for a host that has gone away, so they neither hold up whoever is
+// queueing reports while there is no connection nor reach the host late once it reconnects.
+static void hog_report_queues_purge(void) {
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+    k_work_cancel_delayable(&hog_deferred_send_work);
+    atomic_set(&hog_deferred_send_due, false);
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+
+    for (int i = 0; i < ARRAY_SIZE(hog_report_sources); i++) {
+        hog_report_queue_purge(hog_report_sources[i].queue);
+    }
+}
+
+static void hog_send_callback(struct k_work *work) {
+    struct bt_conn *conn = destination_connection();
+    if (conn == NULL) {
+        hog_report_queues_purge();
+        return;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+    bool send_deferred = hog_deferred_reports_due();
+#else
+    bool send_deferred = true;
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+
+    bool pending = true;
+    while (pending) {
+        pending = false;
+
+        for (int i = 0; i < ARRAY_SIZE(hog_report_sources); i++) {
+            if (hog_report_sources[i].deferrable && !send_deferred) {
+                continue;
+            }
+
+            int ret = hog_send_next_report(conn, &hog_report_sources[i]);
+            if (ret == -EBUSY) {
+                // hog_notify_complete resubmits this work once a notification has been sent.
+                bt_conn_unref(conn);
+                return;
+            }
+
+            pending = pending || ret == 0;
+        }
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+    if (send_deferred) {
+        atomic_set(&hog_deferred_send_due, false);
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+
+    bt_conn_unref(conn);
+}
+
+// Links to anything other than the host of the active profile, such as split peripherals,
+// don't carry HID reports.
+static bool hog_is_host_conn(struct bt_conn *conn) {
+    return bt_addr_le_cmp(bt_conn_get_dst(conn), zmk_ble_active_profile_addr()) == 0;
+}
+
+static void hog_disconnected(struct bt_conn *conn, uint8_t reason) {
+    if (!hog_is_host_conn(conn)) {
+        return;
+    }
+
+    hog_notify_credits_reset();
+    hog_report_queues_purge();
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+    hog_conn_event_reset();
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+}
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+static void hog_le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
+                                 uint16_t timeout) {
+    if (hog_is_host_conn(conn)) {
+        hog_conn_event_reset();
+    }
+}
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+
+BT_CONN_CB_DEFINE(hog_conn_callbacks) = {
+    .disconnected = hog_disconnected,
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+    .le_param_updated = hog_le_param_updated,
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
 };
 
-#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+static int hog_listener(const zmk_event_t *eh) {
+    if (as_zmk_ble_active_profile_changed(eh)) {
+        hog_notify_credits_reset();
+        hog_report_queues_purge();
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+        hog_conn_event_reset();
+#endif // IS_ENABLED(CONFIG_ZMK_BLE_CONN_EVENT_ALIGNED_REPORTS)
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(hog, hog_listener);
+ZMK_SUBSCRIPTION(hog, zmk_ble_active_profile_changed);
 
 static int zmk_hog_init(void) {
+    hog_report_queue_init(&keyboard_queue);
+    hog_report_queue_init(&consumer_queue);
+#if IS_ENABLED(CONFIG_ZMK_MOUSE)
+    hog_report_queue_init(&mouse_queue);
+#endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+
     static const struct k_work_queue_config queue_config = {.name = "HID Over GATT Send Work"};
     k_work_queue_start(&hog_work_q, hog_q_stack, K_THREAD_STACK_SIZEOF(hog_q_stack),
                        CONFIG_ZMK_BLE_THREAD_PRIORITY, &queue_config);
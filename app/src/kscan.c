@@ -12,6 +12,10 @@
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+#include <zmk/kscan.h>
+#include <zmk/kscan_timestamp.h>
+#include <zmk/kscan_trace.h>
+#include <zmk/matrix.h>
 #include <zmk/matrix_transform.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
@@ -19,10 +23,14 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #define ZMK_KSCAN_EVENT_STATE_PRESSED 0
 #define ZMK_KSCAN_EVENT_STATE_RELEASED 1
 
+#define POSITION_STATE_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+
 struct zmk_kscan_event {
     uint32_t row;
     uint32_t column;
+    int32_t position;
     uint32_t state;
+    int64_t timestamp;
 };
 
 struct zmk_kscan_msg_processor {
@@ -31,40 +39,148 @@ struct zmk_kscan_msg_processor {
 
 K_MSGQ_DEFINE(zmk_kscan_msgq, sizeof(struct zmk_kscan_event), CONFIG_ZMK_KSCAN_EVENT_QUEUE_SIZE, 4);
 
-static void zmk_kscan_callback(const struct device *dev, uint32_t row, uint32_t column,
-                               bool pressed) {
+/*
+ * KSCAN drivers may call back from any context, so their events are handed to the system work
+ * queue through zmk_kscan_msgq. When a burst overflows it, further events are not queued. Once
+ * the queue has drained, the keymap is instead brought in line with the latest state reported by
+ * the driver. Every key ends up in the right state, but a key pressed and released again while the
+ * queue was full is never seen.
+ */
+static struct {
+    // Latest state of each position as reported by the driver.
+    uint8_t reported_state[POSITION_STATE_LEN];
+    // State of each position as last raised to the keymap.
+    uint8_t raised_state[POSITION_STATE_LEN];
+    bool overflowed;
+    // Byte of the bitmaps where the next resync comparison continues.
+    size_t resync_index;
+    struct zmk_kscan_event_queue_stats stats;
+} queue_state;
+
+// Protects queue_state, and keeps it in step with zmk_kscan_msgq.
+static struct k_spinlock queue_lock;
+
+static void zmk_kscan_timestamp_callback(const struct device *dev, uint32_t row, uint32_t column,
+                                         bool pressed, int64_t timestamp) {
     struct zmk_kscan_event ev = {
         .row = row,
         .column = column,
-        .state = (pressed ? ZMK_KSCAN_EVENT_STATE_PRESSED : ZMK_KSCAN_EVENT_STATE_RELEASED)};
+        .position = zmk_matrix_transform_row_column_to_position(row, column),
+        .state = (pressed ? ZMK_KSCAN_EVENT_STATE_PRESSED : ZMK_KSCAN_EVENT_STATE_RELEASED),
+        .timestamp = timestamp};
+
+#if IS_ENABLED(CONFIG_ZMK_KSCAN_TRACE)
+    zmk_kscan_trace_record(row, column, pressed, ev.timestamp);
+#endif // IS_ENABLED(CONFIG_ZMK_KSCAN_TRACE)
+
+    if (ev.position < 0) {
+        LOG_WRN("Not found in transform: row: %d, col: %d, pressed: %s", row, column,
+                (pressed ? "true" : "false"));
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&queue_lock);
+
+    WRITE_BIT(queue_state.reported_state[ev.position / 8], ev.position % 8, pressed);
+
+    if (queue_state.overflowed) {
+        // A resync is already pending and will cover this event, though it may have to go back
+        // over a position it has already compared.
+        queue_state.resync_index = MIN(queue_state.resync_index, ev.position / 8);
+    } else if (k_msgq_put(&zmk_kscan_msgq, &ev, K_NO_WAIT) != 0) {
+        LOG_WRN("KSCAN event queue full, resyncing from the reported key state");
+        queue_state.overflowed = true;
+        queue_state.resync_index = 0;
+        queue_state.stats.overflows++;
+    } else {
+        queue_state.stats.max_depth =
+            MAX(queue_state.stats.max_depth, k_msgq_num_used_get(&zmk_kscan_msgq));
+    }
+
+    k_spin_unlock(&queue_lock, key);
 
-    k_msgq_put(&zmk_kscan_msgq, &ev, K_NO_WAIT);
     k_work_submit(&msg_processor.work);
 }
 
+static void zmk_kscan_callback(const struct device *dev, uint32_t row, uint32_t column,
+                               bool pressed) {
+    zmk_kscan_timestamp_callback(dev, row, column, pressed, k_uptime_get());
+}
+
+// Finds the next position whose raised state differs from the reported state. Must be called
+// with queue_lock held.
+static bool zmk_kscan_resync(struct zmk_kscan_event *ev) {
+    for (; queue_state.resync_index < POSITION_STATE_LEN; queue_state.resync_index++) {
+        uint8_t changed = queue_state.raised_state[queue_state.resync_index] ^
+                          queue_state.reported_state[queue_state.resync_index];
+        if (!changed) {
+            continue;
+        }
+
+        int bit = __builtin_ctz(changed);
+        int32_t position = (queue_state.resync_index * 8) + bit;
+        bool pressed = queue_state.reported_state[queue_state.resync_index] & BIT(bit);
+
+        *ev = (struct zmk_kscan_event){
+            .position = position,
+            .state = (pressed ? ZMK_KSCAN_EVENT_STATE_PRESSED : ZMK_KSCAN_EVENT_STATE_RELEASED),
+            .timestamp = k_uptime_get()};
+        return true;
+    }
+
+    queue_state.overflowed = false;
+    queue_state.stats.resyncs++;
+    return false;
+}
+
+static bool zmk_kscan_next_event(struct zmk_kscan_event *ev) {
+    bool found = false;
+
+    k_spinlock_key_t key = k_spin_lock(&queue_lock);
+
+    if (k_msgq_get(&zmk_kscan_msgq, ev, K_NO_WAIT) == 0) {
+        found = true;
+    } else if (queue_state.overflowed) {
+        found = zmk_kscan_resync(ev);
+        if (found) {
+            LOG_DBG("Resyncing position %d", ev->position);
+        }
+    }
+
+    if (found) {
+        WRITE_BIT(queue_state.raised_state[ev->position / 8], ev->position % 8,
+                  ev->state == ZMK_KSCAN_EVENT_STATE_PRESSED);
+    }
+
+    k_spin_unlock(&queue_lock, key);
+
+    return found;
+}
+
 void zmk_kscan_process_msgq(struct k_work *item) {
     struct zmk_kscan_event ev;
 
-    while (k_msgq_get(&zmk_kscan_msgq, &ev, K_NO_WAIT) == 0) {
+    while (zmk_kscan_next_event(&ev)) {
         bool pressed = (ev.state == ZMK_KSCAN_EVENT_STATE_PRESSED);
-        int32_t position = zmk_matrix_transform_row_column_to_position(ev.row, ev.column);
-
-        if (position < 0) {
-            LOG_WRN("Not found in transform: row: %d, col: %d, pressed: %s", ev.row, ev.column,
-                    (pressed ? "true" : "false"));
-            continue;
-        }
 
-        LOG_DBG("Row: %d, col: %d, position: %d, pressed: %s", ev.row, ev.column, position,
+        LOG_DBG("Row: %d, col: %d, position: %d, pressed: %s", ev.row, ev.column, ev.position,
                 (pressed ? "true" : "false"));
         raise_zmk_position_state_changed(
             (struct zmk_position_state_changed){.source = ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL,
                                                 .state = pressed,
-                                                .position = position,
-                                                .timestamp = k_uptime_get()});
+                                                .position = ev.position,
+                                                .timestamp = ev.timestamp});
     }
 }
 
+int zmk_kscan_get_event_queue_stats(struct zmk_kscan_event_queue_stats *stats) {
+    k_spinlock_key_t key = k_spin_lock(&queue_lock);
+    *stats = queue_state.stats;
+    k_spin_unlock(&queue_lock, key);
+
+    return 0;
+}
+
 int zmk_kscan_init(const struct device *dev) {
     if (dev == NULL) {
         LOG_ERR("Failed to get the KSCAN device");
@@ -73,7 +189,10 @@ int zmk_kscan_init(const struct device *dev) {
 
     k_work_init(&msg_processor.work, zmk_kscan_process_msgq);
 
-    kscan_config(dev, zmk_kscan_callback);
+    // Drivers that can't tell when a key state was read get it stamped with the callback time.
+    if (zmk_kscan_config_timestamp(dev, zmk_kscan_timestamp_callback) == -ENOTSUP) {
+        kscan_config(dev, zmk_kscan_callback);
+    }
     kscan_enable_callback(dev);
 
     return 0;
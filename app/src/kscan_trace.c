@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+
+// Registered separately, so the trace is logged at any ZMK log level and is easy to pick out.
+LOG_MODULE_REGISTER(kscan_trace, LOG_LEVEL_INF);
+
+#include <zmk/kscan_trace.h>
+#include <zmk/workqueue.h>
+
+// Bytes of the trace logged per line.
+#define LINE_LEN 32
+#define FLUSH_DELAY K_MSEC(1000)
+
+RING_BUF_DECLARE(trace_buf, CONFIG_ZMK_KSCAN_TRACE_BUFFER_SIZE);
+
+// Protects trace_buf and the fields below, since KSCAN drivers may call back from any context.
+static struct k_spinlock trace_lock;
+// Timestamp of the last recorded event, or -1 before the first one.
+static int64_t last_timestamp = -1;
+static uint32_t dropped_events;
+// Events whose row or column doesn't fit into a record.
+static uint32_t skipped_events;
+
+static void trace_flush_work_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(trace_flush_work, trace_flush_work_callback);
+
+static void trace_flush_work_callback(struct k_work *work) {
+    uint8_t line[LINE_LEN];
+    char hex[(LINE_LEN * 2) + 1];
+    uint32_t len;
+
+    do {
+        k_spinlock_key_t key = k_spin_lock(&trace_lock);
+        len = ring_buf_get(&trace_buf, line, sizeof(line));
+        uint32_t dropped = dropped_events;
+        uint32_t skipped = skipped_events;
+        dropped_events = 0;
+        skipped_events = 0;
+        k_spin_unlock(&trace_lock, key);
+
+        if (dropped > 0) {
+            LOG_WRN("Trace buffer full, dropped %d events", dropped);
+        }
+
+        if (skipped > 0) {
+            LOG_WRN("Skipped %d events beyond row %d or column %d", skipped,
+                    ZMK_KSCAN_TRACE_DELAY_ROW - 1, ZMK_KSCAN_TRACE_COLUMN_MASK);
+        }
+
+        if (len > 0) {
+            bin2hex(line, len, hex, sizeof(hex));
+            LOG_INF("%s", hex);
+        }
+    } while (len == sizeof(line));
+}
+
+// Must be called with trace_lock held, and with room for the record.
+static void trace_put(uint16_t delay_ms, uint8_t row, uint8_t column) {
+    const struct zmk_kscan_trace_record record = {
+        .delay_ms = sys_cpu_to_le16(delay_ms),
+        .row = row,
+        .column = column,
+    };
+
+    ring_buf_put(&trace_buf, (const uint8_t *)&record, sizeof(record));
+}
+
+void zmk_kscan_trace_record(uint32_t row, uint32_t column, bool pressed, int64_t timestamp) {
+    k_spinlock_key_t key = k_spin_lock(&trace_lock);
+
+    if (row >= ZMK_KSCAN_TRACE_DELAY_ROW || column > ZMK_KSCAN_TRACE_COLUMN_MASK) {
+        // Recording it would replay as a delay record or as a different key. Its time is added to
+        // the delay of the next event instead.
+        skipped_events++;
+        k_spin_unlock(&trace_lock, key);
+        k_work_schedule_for_queue(zmk_workqueue_lowprio_work_q(), &trace_flush_work, FLUSH_DELAY);
+        return;
+    }
+
+    int64_t delay_ms = last_timestamp < 0 ? 0 : MAX(timestamp - last_timestamp, 0);
+    // Whatever doesn't fit into the event record itself goes into delay records before it.
+    uint32_t delay_records =
+        delay_ms > UINT16_MAX ? DIV_ROUND_UP(delay_ms - UINT16_MAX, ZMK_KSCAN_TRACE_DELAY_MAX) : 0;
+
+    if (ring_buf_space_get(&trace_buf) <
+        (delay_records + 1) * sizeof(struct zmk_kscan_trace_record)) {
+        dropped_events++;
+    } else {
+        while (delay_ms > UINT16_MAX) {
+            uint32_t delay = MIN(delay_ms, ZMK_KSCAN_TRACE_DELAY_MAX);
+
+            trace_put(delay & UINT16_MAX, ZMK_KSCAN_TRACE_DELAY_ROW, delay >> 16);
+            delay_ms -= delay;
+        }
+
+        trace_put(delay_ms, row, column | (pressed ? ZMK_KSCAN_TRACE_PRESSED : 0));
+        last_timestamp = MAX(timestamp, last_timestamp);
+    }
+
+    bool half_full = ring_buf_size_get(&trace_buf) >= CONFIG_ZMK_KSCAN_TRACE_BUFFER_SIZE / 2;
+
+    k_spin_unlock(&trace_lock, key);
+
+    if (half_full) {
+        k_work_reschedule_for_queue(zmk_workqueue_lowprio_work_q(), &trace_flush_work, K_NO_WAIT);
+    } else {
+        k_work_schedule_for_queue(zmk_workqueue_lowprio_work_q(), &trace_flush_work, FLUSH_DELAY);
+    }
+}
+
+static int zmk_kscan_trace_init(void) {
+    uint8_t header[ZMK_KSCAN_TRACE_HEADER_LEN] = ZMK_KSCAN_TRACE_MAGIC;
+
+    header[ZMK_KSCAN_TRACE_HEADER_LEN - 1] = ZMK_KSCAN_TRACE_VERSION;
+    ring_buf_put(&trace_buf, header, sizeof(header));
+
+    return 0;
+}
+
+SYS_INIT(zmk_kscan_trace_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -6,6 +6,9 @@
 
 #include <zephyr/types.h>
 #include <zephyr/init.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/conn.h>
@@ -14,6 +17,10 @@
 #include <zephyr/bluetooth/hci.h>
 #include <zephyr/sys/byteorder.h>
 
+#if IS_ENABLED(CONFIG_SETTINGS)
+#include <zephyr/settings/settings.h>
+#endif
+
 #include <zephyr/logging/log.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
@@ -22,9 +29,13 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/ble.h>
 #include <zmk/behavior.h>
 #include <zmk/sensors.h>
+#include <zmk/sensor_delta.h>
 #include <zmk/split/bluetooth/uuid.h>
 #include <zmk/split/bluetooth/service.h>
+#include <zmk/split/bluetooth/central.h>
+#include <zmk/split/central.h>
 #include <zmk/event_manager.h>
+#include <zmk/events/activity_state_changed.h>
 #include <zmk/events/position_state_changed.h>
 #include <zmk/events/sensor_event.h>
 #include <zmk/events/battery_state_changed.h>
@@ -32,7 +43,28 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 static int start_scanning(void);
 
-#define POSITION_STATE_DATA_LEN 16
+// Number of position event notifications over which the minimum clock offset is tracked before
+// it is re-estimated, so that drift between the two clocks is followed.
+#define CLOCK_OFFSET_WINDOW 32
+
+/*
+ * Position changes from each peripheral are handed from the BLE RX context to the system work
+ * queue through a small per-peripheral ring. When a burst overflows the ring, further events are
+ * not queued. Once the ring has drained, the keymap is instead brought in line with the latest
+ * position state bitmap of that peripheral. Held keys end up in the right state, but a key pressed
+ * and released again while the ring was full is never seen.
+ */
+struct peripheral_event_queue {
+    struct zmk_position_state_changed events[CONFIG_ZMK_SPLIT_BLE_CENTRAL_POSITION_QUEUE_SIZE];
+    size_t head;
+    size_t count;
+    bool overflowed;
+    // Byte of the bitmap where the next resync comparison continues.
+    size_t resync_index;
+    // Position state as last raised to the keymap.
+    uint8_t raised_state[ZMK_SPLIT_POS_STATE_LEN];
+    struct zmk_split_central_position_queue_stats stats;
+};
 
 enum peripheral_slot_state {
     PERIPHERAL_SLOT_STATE_OPEN,
@@ -45,9 +77,24 @@ struct peripheral_slot {
     struct bt_conn *conn;
     struct bt_gatt_discover_params discover_params;
     struct bt_gatt_subscribe_params subscribe_params;
+    struct bt_gatt_subscribe_params events_subscribe_params;
+    struct bt_gatt_read_params position_state_read_params;
     struct bt_gatt_subscribe_params sensor_subscribe_params;
+    struct bt_gatt_subscribe_params sensor_deltas_subscribe_params;
     struct bt_gatt_discover_params sub_discover_params;
     uint16_t run_behavior_handle;
+    uint16_t invoke_behavior_handle;
+    struct bt_gatt_read_params behavior_table_read_params;
+    // Set once the peripheral is known to assign the same behavior IDs as we do.
+    bool behavior_table_matches;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+    struct bt_gatt_read_params db_hash_read_params;
+    uint8_t db_hash[16];
+    bool db_hash_valid;
+    // Set once all handles are known, either from discovery or from the cache.
+    bool handles_complete;
+    bool handles_from_cache;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
     struct bt_gatt_subscribe_params batt_lvl_subscribe_params;
     struct bt_gatt_read_params batt_lvl_read_params;
@@ -55,8 +102,17 @@ struct peripheral_slot {
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     uint16_t update_hid_indicators;
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
-    uint8_t position_state[POSITION_STATE_DATA_LEN];
-    uint8_t changed_positions[POSITION_STATE_DATA_LEN];
+    uint8_t position_state[ZMK_SPLIT_POS_STATE_LEN];
+    struct peripheral_event_queue event_queue;
+    uint8_t position_events_sequence;
+    bool position_events_synced;
+    bool position_state_resync_pending;
+    uint16_t position_state_read_offset;
+    // Lower 32 bits of central minus peripheral uptime, plus the minimum link latency.
+    uint32_t clock_offset;
+    uint32_t clock_offset_window_min;
+    uint8_t clock_offset_samples;
+    bool clock_offset_valid;
 };
 
 static struct peripheral_slot peripherals[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
@@ -65,19 +121,107 @@ static bool is_scanning = false;
 
 static const struct bt_uuid_128 split_service_uuid = BT_UUID_INIT_128(ZMK_SPLIT_BT_SERVICE_UUID);
 
-K_MSGQ_DEFINE(peripheral_event_msgq, sizeof(struct zmk_position_state_changed),
-              CONFIG_ZMK_SPLIT_BLE_CENTRAL_POSITION_QUEUE_SIZE, 4);
+// Protects the position state and event queue of all peripheral slots.
+static struct k_spinlock peripheral_event_lock;
+
+// Must be called with peripheral_event_lock held.
+static void peripheral_event_queue_put(struct peripheral_event_queue *queue,
+                                       const struct zmk_position_state_changed *ev) {
+    if (queue->overflowed) {
+        // A resync is already pending and will cover this event.
+        return;
+    }
+
+    if (queue->count == ARRAY_SIZE(queue->events)) {
+        LOG_WRN("Peripheral %d event queue full, resyncing from its position state", ev->source);
+        queue->overflowed = true;
+        queue->resync_index = 0;
+        queue->stats.overflows++;
+        return;
+    }
+
+    queue->events[(queue->head + queue->count) % ARRAY_SIZE(queue->events)] = *ev;
+    queue->count++;
+    queue->stats.max_depth = MAX(queue->stats.max_depth, queue->count);
+}
+
+// Finds the next position whose raised state differs from the peripheral's position state. Must
+// be called with peripheral_event_lock held.
+static bool peripheral_event_queue_resync(struct peripheral_event_queue *queue,
+                                          const uint8_t *position_state, uint8_t source,
+                                          struct zmk_position_state_changed *ev) {
+    for (; queue->resync_index < ZMK_SPLIT_POS_STATE_LEN; queue->resync_index++) {
+        uint8_t changed = queue->raised_state[queue->resync_index] ^
+                          position_state[queue->resync_index];
+        if (!changed) {
+            continue;
+        }
+
+        int bit = __builtin_ctz(changed);
+        *ev = (struct zmk_position_state_changed){
+            .source = source,
+            .position = (queue->resync_index * 8) + bit,
+            .state = position_state[queue->resync_index] & BIT(bit),
+            .timestamp = k_uptime_get()};
+        return true;
+    }
+
+    queue->overflowed = false;
+    queue->stats.resyncs++;
+    return false;
+}
+
+static bool peripheral_event_queue_get(uint8_t source, struct zmk_position_state_changed *ev) {
+    struct peripheral_slot *slot = &peripherals[source];
+    struct peripheral_event_queue *queue = &slot->event_queue;
+    bool found = false;
+
+    k_spinlock_key_t key = k_spin_lock(&peripheral_event_lock);
+
+    if (queue->count > 0) {
+        *ev = queue->events[queue->head];
+        queue->head = (queue->head + 1) % ARRAY_SIZE(queue->events);
+        queue->count--;
+        found = true;
+    } else if (queue->overflowed) {
+        found = peripheral_event_queue_resync(queue, slot->position_state, source, ev);
+    }
+
+    if (found) {
+        WRITE_BIT(queue->raised_state[ev->position / 8], ev->position % 8, ev->state);
+    }
+
+    k_spin_unlock(&peripheral_event_lock, key);
+
+    return found;
+}
 
 void peripheral_event_work_callback(struct k_work *work) {
     struct zmk_position_state_changed ev;
-    while (k_msgq_get(&peripheral_event_msgq, &ev, K_NO_WAIT) == 0) {
-        LOG_DBG("Trigger key position state change for %d", ev.position);
-        raise_zmk_position_state_changed(ev);
+
+    for (uint8_t i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        while (peripheral_event_queue_get(i, &ev)) {
+            LOG_DBG("Trigger key position state change for %d, state %d", ev.position, ev.state);
+            raise_zmk_position_state_changed(ev);
+        }
     }
 }
 
 K_WORK_DEFINE(peripheral_event_work, peripheral_event_work_callback);
 
+int zmk_split_bt_central_get_position_queue_stats(
+    uint8_t source, struct zmk_split_central_position_queue_stats *stats) {
+    if (source >= ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&peripheral_event_lock);
+    *stats = peripherals[source].event_queue.stats;
+    k_spin_unlock(&peripheral_event_lock, key);
+
+    return 0;
+}
+
 int peripheral_slot_index_for_conn(struct bt_conn *conn) {
     for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
         if (peripherals[i].conn == conn) {
@@ -116,33 +260,44 @@ int release_peripheral_slot(int index) {
     }
     slot->state = PERIPHERAL_SLOT_STATE_OPEN;
 
-    // Raise events releasing any active positions from this peripheral
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (slot->position_state[i] & BIT(j)) {
-                uint32_t position = (i * 8) + j;
-                struct zmk_position_state_changed ev = {.source = index,
-                                                        .position = position,
-                                                        .state = false,
-                                                        .timestamp = k_uptime_get()};
-
-                k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
-                k_work_submit(&peripheral_event_work);
-            }
-        }
-    }
+    // Release any active positions from this peripheral by resyncing to an empty position state,
+    // after whatever is still queued.
+    k_spinlock_key_t key = k_spin_lock(&peripheral_event_lock);
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
+    for (int i = 0; i < ZMK_SPLIT_POS_STATE_LEN; i++) {
         slot->position_state[i] = 0U;
-        slot->changed_positions[i] = 0U;
     }
 
+    slot->event_queue.overflowed = true;
+    slot->event_queue.resync_index = 0;
+
+    k_spin_unlock(&peripheral_event_lock, key);
+
+    k_work_submit(&peripheral_event_work);
+
+    slot->position_events_synced = false;
+    slot->position_state_resync_pending = false;
+    slot->clock_offset_valid = false;
+    slot->clock_offset_samples = 0;
+
     // Clean up previously discovered handles;
     slot->subscribe_params.value_handle = 0;
+    slot->events_subscribe_params.value_handle = 0;
     slot->run_behavior_handle = 0;
+    slot->invoke_behavior_handle = 0;
+    slot->behavior_table_matches = false;
+#if ZMK_KEYMAP_HAS_SENSORS
+    slot->sensor_subscribe_params.value_handle = 0;
+    slot->sensor_deltas_subscribe_params.value_handle = 0;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     slot->update_hid_indicators = 0;
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+    slot->db_hash_valid = false;
+    slot->handles_complete = false;
+    slot->handles_from_cache = false;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
 
     return 0;
 }
@@ -184,16 +339,119 @@ int confirm_peripheral_slot_conn(struct bt_conn *conn) {
 K_MSGQ_DEFINE(peripheral_sensor_event_msgq, sizeof(struct zmk_sensor_event),
               CONFIG_ZMK_SPLIT_BLE_CENTRAL_POSITION_QUEUE_SIZE, 4);
 
+/*
+ * Sensor changes that don't fit in the message queue are accumulated per sensor, the same way the
+ * peripheral accumulates sensor deltas, and queued as one event once the queue drains. Later
+ * changes of a sensor with a pending delta are folded into it, so they aren't raised out of order.
+ */
+struct peripheral_sensor_delta {
+    size_t channel_count;
+    struct zmk_sensor_delta channels[ZMK_SENSOR_EVENT_MAX_CHANNELS];
+    bool pending;
+};
+
+static struct peripheral_sensor_delta peripheral_sensor_deltas[ZMK_KEYMAP_SENSORS_LEN];
+
+// Protects peripheral_sensor_deltas.
+static struct k_spinlock peripheral_sensor_deltas_lock;
+
+static void peripheral_sensor_delta_add(struct peripheral_sensor_delta *delta,
+                                        const struct zmk_sensor_event *ev) {
+    for (size_t i = 0; i < ev->channel_data_size; i++) {
+        struct zmk_sensor_delta *channel = NULL;
+
+        for (size_t j = 0; j < delta->channel_count; j++) {
+            if (delta->channels[j].channel == ev->channel_data[i].channel) {
+                channel = &delta->channels[j];
+                break;
+            }
+        }
+
+        if (channel == NULL) {
+            if (delta->channel_count == ZMK_SENSOR_EVENT_MAX_CHANNELS) {
+                continue;
+            }
+
+            channel = &delta->channels[delta->channel_count++];
+            *channel = (struct zmk_sensor_delta){.channel = ev->channel_data[i].channel};
+        }
+
+        zmk_sensor_delta_add(channel, &ev->channel_data[i].value);
+    }
+
+    delta->pending = true;
+}
+
+// Queues the pending sensor deltas that fit in the message queue. Returns how many were queued.
+static int peripheral_sensor_deltas_flush(void) {
+    int queued = 0;
+    k_spinlock_key_t key = k_spin_lock(&peripheral_sensor_deltas_lock);
+
+    for (size_t sensor_index = 0; sensor_index < ZMK_KEYMAP_SENSORS_LEN; sensor_index++) {
+        struct peripheral_sensor_delta *delta = &peripheral_sensor_deltas[sensor_index];
+        struct zmk_sensor_event ev = {.sensor_index = sensor_index, .timestamp = k_uptime_get()};
+        bool changed = false;
+
+        if (!delta->pending) {
+            continue;
+        }
+
+        for (size_t i = 0; i < delta->channel_count; i++) {
+            ev.channel_data[i].channel = delta->channels[i].channel;
+            changed |= zmk_sensor_delta_get(&delta->channels[i], &ev.channel_data[i].value);
+        }
+        ev.channel_data_size = delta->channel_count;
+
+        if (!changed) {
+            // A rotation of less than one degree waits for more readings to be added to it.
+            continue;
+        }
+
+        if (k_msgq_put(&peripheral_sensor_event_msgq, &ev, K_NO_WAIT) != 0) {
+            break;
+        }
+
+        for (size_t i = 0; i < delta->channel_count; i++) {
+            zmk_sensor_delta_sent(&delta->channels[i], &ev.channel_data[i].value);
+        }
+        delta->pending = false;
+        queued++;
+    }
+
+    k_spin_unlock(&peripheral_sensor_deltas_lock, key);
+    return queued;
+}
+
 void peripheral_sensor_event_work_callback(struct k_work *work) {
     struct zmk_sensor_event ev;
-    while (k_msgq_get(&peripheral_sensor_event_msgq, &ev, K_NO_WAIT) == 0) {
-        LOG_DBG("Trigger sensor change for %d", ev.sensor_index);
-        raise_zmk_sensor_event(ev);
-    }
+    do {
+        while (k_msgq_get(&peripheral_sensor_event_msgq, &ev, K_NO_WAIT) == 0) {
+            LOG_DBG("Trigger sensor change for %d", ev.sensor_index);
+            raise_zmk_sensor_event(ev);
+        }
+    } while (peripheral_sensor_deltas_flush() > 0);
 }
 
 K_WORK_DEFINE(peripheral_sensor_event_work, peripheral_sensor_event_work_callback);
 
+static void split_central_queue_sensor_event(const struct zmk_sensor_event *ev) {
+    if (ev->sensor_index >= ZMK_KEYMAP_SENSORS_LEN) {
+        LOG_WRN("Ignoring change of unknown sensor %d", ev->sensor_index);
+        return;
+    }
+
+    struct peripheral_sensor_delta *delta = &peripheral_sensor_deltas[ev->sensor_index];
+    k_spinlock_key_t key = k_spin_lock(&peripheral_sensor_deltas_lock);
+
+    if (delta->pending || k_msgq_put(&peripheral_sensor_event_msgq, ev, K_NO_WAIT) != 0) {
+        LOG_DBG("Accumulating change of sensor %d until the sensor event queue drains",
+                ev->sensor_index);
+        peripheral_sensor_delta_add(delta, ev);
+    }
+
+    k_spin_unlock(&peripheral_sensor_deltas_lock, key);
+}
+
 static uint8_t split_central_sensor_notify_func(struct bt_conn *conn,
                                                 struct bt_gatt_subscribe_params *params,
                                                 const void *data, uint16_t length) {
@@ -219,13 +477,106 @@ static uint8_t split_central_sensor_notify_func(struct bt_conn *conn,
 
     memcpy(ev.channel_data, sensor_event.channel_data,
            sizeof(struct zmk_sensor_channel_data) * sensor_event.channel_data_size);
-    k_msgq_put(&peripheral_sensor_event_msgq, &ev, K_NO_WAIT);
+    split_central_queue_sensor_event(&ev);
+    k_work_submit(&peripheral_sensor_event_work);
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+
+static uint8_t split_central_sensor_deltas_notify_func(struct bt_conn *conn,
+                                                       struct bt_gatt_subscribe_params *params,
+                                                       const void *data, uint16_t length) {
+    if (!data) {
+        LOG_DBG("[UNSUBSCRIBED]");
+        params->value_handle = 0U;
+        return BT_GATT_ITER_STOP;
+    }
+
+    LOG_DBG("[SENSOR DELTAS NOTIFICATION] data %p length %u", data, length);
+
+    const struct zmk_split_sensor_delta *deltas = data;
+    size_t count = length / sizeof(struct zmk_split_sensor_delta);
+    struct zmk_sensor_event ev = {.channel_data_size = 0};
+
+    // Consecutive records for the same sensor are the channels of a single sensor event.
+    for (size_t i = 0; i < count; i++) {
+        struct zmk_split_sensor_delta delta;
+        memcpy(&delta, &deltas[i], sizeof(delta));
+
+        if (ev.channel_data_size > 0 && (ev.sensor_index != delta.sensor_index ||
+                                         ev.channel_data_size == ZMK_SENSOR_EVENT_MAX_CHANNELS)) {
+            split_central_queue_sensor_event(&ev);
+            ev.channel_data_size = 0;
+        }
+
+        ev.sensor_index = delta.sensor_index;
+        ev.timestamp = k_uptime_get();
+        ev.channel_data[ev.channel_data_size++] = (struct zmk_sensor_channel_data){
+            .channel = sys_le16_to_cpu(delta.channel),
+            .value = {.val1 = sys_le32_to_cpu(delta.val1), .val2 = sys_le32_to_cpu(delta.val2)},
+        };
+    }
+
+    if (ev.channel_data_size > 0) {
+        split_central_queue_sensor_event(&ev);
+    }
+
     k_work_submit(&peripheral_sensor_event_work);
 
     return BT_GATT_ITER_CONTINUE;
 }
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
+static void split_central_set_position(struct peripheral_slot *slot, uint32_t position,
+                                       bool pressed, int64_t timestamp) {
+    if (position >= ZMK_SPLIT_POS_STATE_LEN * 8) {
+        LOG_WRN("Ignoring out of range position %d", position);
+        return;
+    }
+
+    struct zmk_position_state_changed ev = {.source = slot - peripherals,
+                                            .position = position,
+                                            .state = pressed,
+                                            .timestamp = timestamp};
+
+    k_spinlock_key_t key = k_spin_lock(&peripheral_event_lock);
+
+    // Events may be seen twice around a resync, so only raise actual changes.
+    bool changed = ((slot->position_state[position / 8] & BIT(position % 8)) != 0) != pressed;
+    if (changed) {
+        WRITE_BIT(slot->position_state[position / 8], position % 8, pressed);
+        peripheral_event_queue_put(&slot->event_queue, &ev);
+    }
+
+    k_spin_unlock(&peripheral_event_lock, key);
+
+    if (changed) {
+        k_work_submit(&peripheral_event_work);
+    }
+}
+
+// Applies part of a position state bitmap, starting at the given byte offset.
+static void split_central_apply_position_state(struct peripheral_slot *slot, uint16_t offset,
+                                               const uint8_t *data, uint16_t length) {
+    int64_t now = k_uptime_get();
+
+    for (int i = 0; i < length && offset + i < ZMK_SPLIT_POS_STATE_LEN; i++) {
+        uint8_t changed_positions = data[i] ^ slot->position_state[offset + i];
+
+        // Most of a large bitmap is unchanged, skip those bytes cheaply.
+        if (!changed_positions) {
+            continue;
+        }
+
+        for (int j = 0; j < 8; j++) {
+            if (changed_positions & BIT(j)) {
+                split_central_set_position(slot, ((offset + i) * 8) + j, data[i] & BIT(j), now);
+            }
+        }
+    }
+}
+
 static uint8_t split_central_notify_func(struct bt_conn *conn,
                                          struct bt_gatt_subscribe_params *params, const void *data,
                                          uint16_t length) {
@@ -244,27 +595,143 @@ static uint8_t split_central_notify_func(struct bt_conn *conn,
 
     LOG_DBG("[NOTIFICATION] data %p length %u", data, length);
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        slot->changed_positions[i] = ((uint8_t *)data)[i] ^ slot->position_state[i];
-        slot->position_state[i] = ((uint8_t *)data)[i];
-        LOG_DBG("data: %d", slot->position_state[i]);
+    split_central_apply_position_state(slot, 0, data, length);
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t split_central_position_state_read_func(struct bt_conn *conn, uint8_t err,
+                                                      struct bt_gatt_read_params *params,
+                                                      const void *data, uint16_t length) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+
+    if (!slot) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_STOP;
     }
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (slot->changed_positions[i] & BIT(j)) {
-                uint32_t position = (i * 8) + j;
-                bool pressed = slot->position_state[i] & BIT(j);
-                struct zmk_position_state_changed ev = {.source =
-                                                            peripheral_slot_index_for_conn(conn),
-                                                        .position = position,
-                                                        .state = pressed,
-                                                        .timestamp = k_uptime_get()};
-
-                k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
-                k_work_submit(&peripheral_event_work);
-            }
+    if (err > 0 || !data) {
+        if (err > 0) {
+            LOG_ERR("Error during reading peripheral position state: %u", err);
         }
+
+        slot->position_state_resync_pending = false;
+        return BT_GATT_ITER_STOP;
+    }
+
+    LOG_DBG("[POSITION STATE READ] data %p length %u", data, length);
+
+    // Bitmaps that don't fit in one response arrive in several chunks.
+    split_central_apply_position_state(slot, slot->position_state_read_offset, data, length);
+    slot->position_state_read_offset += length;
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static void split_central_resync_position_state(struct bt_conn *conn,
+                                                struct peripheral_slot *slot) {
+    if (slot->position_state_resync_pending || !slot->subscribe_params.value_handle) {
+        return;
+    }
+
+    slot->position_state_read_params.func = split_central_position_state_read_func;
+    slot->position_state_read_params.handle_count = 1;
+    slot->position_state_read_params.single.handle = slot->subscribe_params.value_handle;
+    slot->position_state_read_params.single.offset = 0;
+
+    slot->position_state_read_offset = 0;
+
+    int err = bt_gatt_read(conn, &slot->position_state_read_params);
+    if (err) {
+        LOG_ERR("Failed to read peripheral position state (err %d)", err);
+        return;
+    }
+
+    slot->position_state_resync_pending = true;
+}
+
+/*
+ * Each position events notification carries the peripheral's clock at the time it was sent. The
+ * difference to our clock on reception is the clock offset plus however long the notification
+ * spent in the radio stacks, so the smallest difference seen is the best estimate of the offset.
+ * The minimum is taken over a sliding window so that clock drift doesn't go unnoticed.
+ */
+static void split_central_update_clock_offset(struct peripheral_slot *slot, uint32_t sample) {
+    if (!slot->clock_offset_valid || (int32_t)(sample - slot->clock_offset) < 0) {
+        slot->clock_offset = sample;
+        slot->clock_offset_valid = true;
+    }
+
+    if (slot->clock_offset_samples == 0 ||
+        (int32_t)(sample - slot->clock_offset_window_min) < 0) {
+        slot->clock_offset_window_min = sample;
+    }
+
+    if (++slot->clock_offset_samples >= CLOCK_OFFSET_WINDOW) {
+        slot->clock_offset = slot->clock_offset_window_min;
+        slot->clock_offset_samples = 0;
+    }
+}
+
+// Maps a peripheral timestamp into our timebase, never placing it in the future.
+static int64_t split_central_peripheral_time(struct peripheral_slot *slot, int64_t now,
+                                             uint32_t peripheral_time) {
+    int32_t elapsed = (int32_t)((uint32_t)now - (peripheral_time + slot->clock_offset));
+
+    return now - MAX(elapsed, 0);
+}
+
+static uint8_t split_central_position_events_notify_func(struct bt_conn *conn,
+                                                         struct bt_gatt_subscribe_params *params,
+                                                         const void *data, uint16_t length) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+
+    if (slot == NULL) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    if (!data) {
+        LOG_DBG("[UNSUBSCRIBED]");
+        params->value_handle = 0U;
+        return BT_GATT_ITER_STOP;
+    }
+
+    LOG_DBG("[POSITION EVENTS NOTIFICATION] data %p length %u", data, length);
+
+    if (length < sizeof(struct zmk_split_position_events)) {
+        LOG_WRN("Ignoring position events notify with insufficient data length (%d)", length);
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    const struct zmk_split_position_events *payload = data;
+    size_t count = (length - sizeof(struct zmk_split_position_events)) /
+                   sizeof(struct zmk_split_position_event);
+
+    // Events that happened before we subscribed or that got lost on the way leave the state
+    // unknown, so fetch the full bitmap to catch up. Events in this notification are still
+    // applied, anything they already cover is ignored when the read completes.
+    if (!slot->position_events_synced || payload->sequence != slot->position_events_sequence) {
+        LOG_DBG("Position events out of sync (expected %d, got %d), resyncing",
+                slot->position_events_sequence, payload->sequence);
+        split_central_resync_position_state(conn, slot);
+    }
+
+    slot->position_events_synced = true;
+    slot->position_events_sequence = payload->sequence + count;
+
+    int64_t now = k_uptime_get();
+    uint32_t sent_at = sys_le32_to_cpu(payload->timestamp);
+
+    split_central_update_clock_offset(slot, (uint32_t)now - sent_at);
+
+    for (size_t i = 0; i < count; i++) {
+        uint16_t state_age = sys_le16_to_cpu(payload->events[i].state_age);
+        uint32_t scanned_at = sent_at - (state_age & ZMK_SPLIT_POSITION_EVENT_AGE_MAX);
+
+        split_central_set_position(slot, sys_le16_to_cpu(payload->events[i].position),
+                                   state_age & ZMK_SPLIT_POSITION_EVENT_PRESSED,
+                                   split_central_peripheral_time(slot, now, scanned_at));
     }
 
     return BT_GATT_ITER_CONTINUE;
@@ -306,89 +773,432 @@ static uint8_t split_central_battery_level_notify_func(struct bt_conn *conn,
                                                        const void *data, uint16_t length) {
     struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
 
-    if (!slot) {
-        LOG_ERR("No peripheral state found for connection");
-        return BT_GATT_ITER_CONTINUE;
+    if (!slot) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    if (!data) {
+        LOG_DBG("[UNSUBSCRIBED]");
+        params->value_handle = 0U;
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (length == 0) {
+        LOG_ERR("Zero length battery notification received");
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    LOG_DBG("[BATTERY LEVEL NOTIFICATION] data %p length %u", data, length);
+    uint8_t battery_level = ((uint8_t *)data)[0];
+    LOG_DBG("Battery level: %u", battery_level);
+    struct zmk_peripheral_battery_state_changed ev = {
+        .source = peripheral_slot_index_for_conn(conn), .state_of_charge = battery_level};
+    k_msgq_put(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT);
+    k_work_submit(&peripheral_batt_lvl_work);
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t split_central_battery_level_read_func(struct bt_conn *conn, uint8_t err,
+                                                     struct bt_gatt_read_params *params,
+                                                     const void *data, uint16_t length) {
+    if (err > 0) {
+        LOG_ERR("Error during reading peripheral battery level: %u", err);
+        return BT_GATT_ITER_STOP;
+    }
+
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+
+    if (!slot) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    if (!data) {
+        LOG_DBG("[READ COMPLETED]");
+        return BT_GATT_ITER_STOP;
+    }
+
+    LOG_DBG("[BATTERY LEVEL READ] data %p length %u", data, length);
+
+    if (length == 0) {
+        LOG_ERR("Zero length battery notification received");
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    uint8_t battery_level = ((uint8_t *)data)[0];
+
+    LOG_DBG("Battery level: %u", battery_level);
+
+    struct zmk_peripheral_battery_state_changed ev = {
+        .source = peripheral_slot_index_for_conn(conn), .state_of_charge = battery_level};
+    k_msgq_put(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT);
+    k_work_submit(&peripheral_batt_lvl_work);
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+
+static uint8_t split_central_behavior_table_read_func(struct bt_conn *conn, uint8_t err,
+                                                     struct bt_gatt_read_params *params,
+                                                     const void *data, uint16_t length) {
+    if (err > 0) {
+        LOG_ERR("Error during reading peripheral behavior table hash: %u", err);
+        return BT_GATT_ITER_STOP;
+    }
+
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+
+    if (!slot) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (length != sizeof(uint32_t)) {
+        LOG_ERR("Unexpected behavior table hash length %u", length);
+        return BT_GATT_ITER_STOP;
+    }
+
+    uint32_t hash = sys_get_le32(data);
+    slot->behavior_table_matches = hash == zmk_behavior_get_table_hash();
+
+    if (slot->behavior_table_matches) {
+        LOG_DBG("Behavior table hash %08x matches, invoking behaviors by ID", hash);
+    } else {
+        LOG_WRN("Behavior table hash %08x differs from ours (%08x), invoking behaviors by name",
+                hash, zmk_behavior_get_table_hash());
+    }
+
+    return BT_GATT_ITER_STOP;
+}
+
+static int split_central_subscribe(struct bt_conn *conn, struct bt_gatt_subscribe_params *params) {
+    int err = bt_gatt_subscribe(conn, params);
+    switch (err) {
+    case -EALREADY:
+        LOG_DBG("[ALREADY SUBSCRIBED]");
+        break;
+    case 0:
+        LOG_DBG("[SUBSCRIBED]");
+        break;
+    default:
+        LOG_ERR("Subscribe failed (err %d)", err);
+        break;
+    }
+
+    return err;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+static void split_central_subscribe_func(struct bt_conn *conn, uint8_t err,
+                                         struct bt_gatt_subscribe_params *params);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+
+// A CCC handle of 0 is found by automatic discovery when subscribing.
+static void split_central_prepare_subscription(struct peripheral_slot *slot,
+                                               struct bt_gatt_subscribe_params *params,
+                                               uint16_t value_handle, uint16_t ccc_handle,
+                                               bt_gatt_notify_func_t notify) {
+    params->disc_params = &slot->sub_discover_params;
+    params->end_handle = slot->discover_params.end_handle;
+    params->value_handle = value_handle;
+    params->ccc_handle = ccc_handle;
+    params->notify = notify;
+    params->value = BT_GATT_CCC_NOTIFY;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+    params->subscribe = split_central_subscribe_func;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+}
+
+static void split_central_read_behavior_table(struct bt_conn *conn, struct peripheral_slot *slot) {
+    // Behaviors are invoked by name until the tables are known to match.
+    slot->behavior_table_read_params.func = split_central_behavior_table_read_func;
+    slot->behavior_table_read_params.handle_count = 1;
+    slot->behavior_table_read_params.single.handle = slot->invoke_behavior_handle;
+    slot->behavior_table_read_params.single.offset = 0;
+    int err = bt_gatt_read(conn, &slot->behavior_table_read_params);
+    if (err) {
+        LOG_ERR("Failed to read peripheral behavior table hash (err %d)", err);
+    }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+
+static void split_central_read_battery_level(struct bt_conn *conn, struct peripheral_slot *slot) {
+    slot->batt_lvl_read_params.func = split_central_battery_level_read_func;
+    slot->batt_lvl_read_params.handle_count = 1;
+    slot->batt_lvl_read_params.single.handle = slot->batt_lvl_subscribe_params.value_handle;
+    slot->batt_lvl_read_params.single.offset = 0;
+    bt_gatt_read(conn, &slot->batt_lvl_read_params);
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+
+/*
+ * Split service handles of each peripheral, along with its address and the hash of its GATT
+ * database. As long as the hash is unchanged, so are the handles, so a reconnecting peripheral
+ * can be subscribed to without discovering it again. All handles are stored regardless of the
+ * enabled features, so the stored size doesn't depend on them.
+ */
+struct peripheral_gatt_cache {
+    bt_addr_le_t addr;
+    uint8_t db_hash[16];
+    uint16_t position_state_handle;
+    uint16_t position_state_ccc_handle;
+    uint16_t position_events_handle;
+    uint16_t position_events_ccc_handle;
+    uint16_t sensor_handle;
+    uint16_t sensor_ccc_handle;
+    uint16_t sensor_deltas_handle;
+    uint16_t sensor_deltas_ccc_handle;
+    uint16_t run_behavior_handle;
+    uint16_t invoke_behavior_handle;
+    uint16_t update_hid_indicators_handle;
+    uint16_t battery_level_handle;
+    uint16_t battery_level_ccc_handle;
+};
+
+static struct peripheral_gatt_cache gatt_caches[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+
+static ATOMIC_DEFINE(gatt_caches_dirty, ZMK_SPLIT_BLE_PERIPHERAL_COUNT);
+
+static void gatt_cache_save_work_callback(struct k_work *work) {
+    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        if (!atomic_test_and_clear_bit(gatt_caches_dirty, i)) {
+            continue;
+        }
+
+        char setting_name[32];
+        sprintf(setting_name, "split/gatt_cache/%d", i);
+
+        int err = settings_save_one(setting_name, &gatt_caches[i], sizeof(gatt_caches[i]));
+        if (err) {
+            LOG_ERR("Failed to save GATT handles of peripheral %d (err %d)", i, err);
+        }
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(gatt_cache_save_work, gatt_cache_save_work_callback);
+
+static int gatt_cache_handle_set(const char *name, size_t len, settings_read_cb read_cb,
+                                 void *cb_arg) {
+    const char *next;
+
+    if (settings_name_steq(name, "gatt_cache", &next) && next) {
+        char *endptr;
+        uint8_t idx = strtoul(next, &endptr, 10);
+        if (*endptr != '\0' || idx >= ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+            LOG_WRN("Invalid peripheral GATT cache index: %s", next);
+            return -EINVAL;
+        }
+
+        if (len != sizeof(struct peripheral_gatt_cache)) {
+            LOG_WRN("Ignoring peripheral GATT cache of unexpected size %d", len);
+            return -EINVAL;
+        }
+
+        int err = read_cb(cb_arg, &gatt_caches[idx], sizeof(struct peripheral_gatt_cache));
+        if (err <= 0) {
+            LOG_ERR("Failed to handle peripheral GATT cache from settings (err %d)", err);
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+static struct settings_handler gatt_cache_handler = {.name = "split",
+                                                     .h_set = gatt_cache_handle_set};
+
+#endif /* IS_ENABLED(CONFIG_SETTINGS) */
+
+static void gatt_cache_set(int index, const struct peripheral_gatt_cache *cache) {
+    gatt_caches[index] = *cache;
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+    atomic_set_bit(gatt_caches_dirty, index);
+    k_work_reschedule(&gatt_cache_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+#endif /* IS_ENABLED(CONFIG_SETTINGS) */
+}
+
+static bool subscription_complete(const struct bt_gatt_subscribe_params *params) {
+    return params->value_handle == 0 || params->ccc_handle != 0;
+}
+
+// Caches the handles of a discovered peripheral, once the handles of its CCCs are known too.
+static void split_central_update_gatt_cache(struct peripheral_slot *slot) {
+    if (!slot->handles_complete || slot->handles_from_cache || !slot->db_hash_valid) {
+        return;
+    }
+
+    // Position state is only subscribed to when there is no position events characteristic.
+    bool complete = slot->events_subscribe_params.value_handle
+                        ? subscription_complete(&slot->events_subscribe_params)
+                        : subscription_complete(&slot->subscribe_params);
+#if ZMK_KEYMAP_HAS_SENSORS
+    // Likewise, sensor state is only subscribed to when there is no sensor deltas characteristic.
+    complete = complete && (slot->sensor_deltas_subscribe_params.value_handle
+                                ? subscription_complete(&slot->sensor_deltas_subscribe_params)
+                                : subscription_complete(&slot->sensor_subscribe_params));
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    complete = complete && subscription_complete(&slot->batt_lvl_subscribe_params);
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+
+    if (!complete) {
+        return;
+    }
+
+    struct peripheral_gatt_cache cache;
+
+    // Zeroed as a whole, padding included, so unchanged handles compare equal.
+    memset(&cache, 0, sizeof(cache));
+    bt_addr_le_copy(&cache.addr, bt_conn_get_dst(slot->conn));
+    memcpy(cache.db_hash, slot->db_hash, sizeof(cache.db_hash));
+    cache.position_state_handle = slot->subscribe_params.value_handle;
+    cache.position_state_ccc_handle = slot->subscribe_params.ccc_handle;
+    cache.position_events_handle = slot->events_subscribe_params.value_handle;
+    cache.position_events_ccc_handle = slot->events_subscribe_params.ccc_handle;
+    cache.run_behavior_handle = slot->run_behavior_handle;
+    cache.invoke_behavior_handle = slot->invoke_behavior_handle;
+#if ZMK_KEYMAP_HAS_SENSORS
+    cache.sensor_handle = slot->sensor_subscribe_params.value_handle;
+    cache.sensor_ccc_handle = slot->sensor_subscribe_params.ccc_handle;
+    cache.sensor_deltas_handle = slot->sensor_deltas_subscribe_params.value_handle;
+    cache.sensor_deltas_ccc_handle = slot->sensor_deltas_subscribe_params.ccc_handle;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    cache.update_hid_indicators_handle = slot->update_hid_indicators;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    cache.battery_level_handle = slot->batt_lvl_subscribe_params.value_handle;
+    cache.battery_level_ccc_handle = slot->batt_lvl_subscribe_params.ccc_handle;
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+
+    if (memcmp(&gatt_caches[slot - peripherals], &cache, sizeof(cache)) == 0) {
+        return;
     }
 
-    if (!data) {
-        LOG_DBG("[UNSUBSCRIBED]");
-        params->value_handle = 0U;
-        return BT_GATT_ITER_STOP;
-    }
+    LOG_DBG("Caching GATT handles of peripheral %d", (int)(slot - peripherals));
+    gatt_cache_set(slot - peripherals, &cache);
+}
 
-    if (length == 0) {
-        LOG_ERR("Zero length battery notification received");
-        return BT_GATT_ITER_CONTINUE;
-    }
+// Forgets cached handles that turned out to be wrong. Reconnecting then discovers them again.
+static void split_central_drop_gatt_cache(struct bt_conn *conn, struct peripheral_slot *slot) {
+    struct peripheral_gatt_cache cache;
 
-    LOG_DBG("[BATTERY LEVEL NOTIFICATION] data %p length %u", data, length);
-    uint8_t battery_level = ((uint8_t *)data)[0];
-    LOG_DBG("Battery level: %u", battery_level);
-    struct zmk_peripheral_battery_state_changed ev = {
-        .source = peripheral_slot_index_for_conn(conn), .state_of_charge = battery_level};
-    k_msgq_put(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT);
-    k_work_submit(&peripheral_batt_lvl_work);
+    LOG_WRN("Cached GATT handles of peripheral %d are stale, disconnecting to rediscover",
+            (int)(slot - peripherals));
 
-    return BT_GATT_ITER_CONTINUE;
-}
+    memset(&cache, 0, sizeof(cache));
+    gatt_cache_set(slot - peripherals, &cache);
+    slot->handles_from_cache = false;
 
-static uint8_t split_central_battery_level_read_func(struct bt_conn *conn, uint8_t err,
-                                                     struct bt_gatt_read_params *params,
-                                                     const void *data, uint16_t length) {
-    if (err > 0) {
-        LOG_ERR("Error during reading peripheral battery level: %u", err);
-        return BT_GATT_ITER_STOP;
-    }
+    bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+}
 
+static void split_central_subscribe_func(struct bt_conn *conn, uint8_t err,
+                                         struct bt_gatt_subscribe_params *params) {
     struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
-
-    if (!slot) {
-        LOG_ERR("No peripheral state found for connection");
-        return BT_GATT_ITER_CONTINUE;
+    if (slot == NULL) {
+        return;
     }
 
-    if (!data) {
-        LOG_DBG("[READ COMPLETED]");
-        return BT_GATT_ITER_STOP;
+    if (err) {
+        LOG_ERR("Subscribing to handle %u failed (err %u)", params->value_handle, err);
+        if (slot->handles_from_cache) {
+            split_central_drop_gatt_cache(conn, slot);
+        }
+        return;
     }
 
-    LOG_DBG("[BATTERY LEVEL READ] data %p length %u", data, length);
+    split_central_update_gatt_cache(slot);
+}
 
-    if (length == 0) {
-        LOG_ERR("Zero length battery notification received");
-        return BT_GATT_ITER_CONTINUE;
+static bool split_central_subscribe_cached(struct bt_conn *conn,
+                                           struct bt_gatt_subscribe_params *params) {
+    if (!params->value_handle) {
+        return true;
     }
 
-    uint8_t battery_level = ((uint8_t *)data)[0];
+    int err = split_central_subscribe(conn, params);
+    return err == 0 || err == -EALREADY;
+}
 
-    LOG_DBG("Battery level: %u", battery_level);
+static bool split_central_apply_gatt_cache(struct bt_conn *conn, struct peripheral_slot *slot,
+                                           const struct peripheral_gatt_cache *cache) {
+    slot->handles_from_cache = true;
+
+    split_central_prepare_subscription(slot, &slot->subscribe_params,
+                                       cache->position_state_handle,
+                                       cache->position_state_ccc_handle, split_central_notify_func);
+    split_central_prepare_subscription(
+        slot, &slot->events_subscribe_params, cache->position_events_handle,
+        cache->position_events_ccc_handle, split_central_position_events_notify_func);
+    slot->run_behavior_handle = cache->run_behavior_handle;
+    slot->invoke_behavior_handle = cache->invoke_behavior_handle;
+#if ZMK_KEYMAP_HAS_SENSORS
+    split_central_prepare_subscription(slot, &slot->sensor_subscribe_params, cache->sensor_handle,
+                                       cache->sensor_ccc_handle, split_central_sensor_notify_func);
+    split_central_prepare_subscription(
+        slot, &slot->sensor_deltas_subscribe_params, cache->sensor_deltas_handle,
+        cache->sensor_deltas_ccc_handle, split_central_sensor_deltas_notify_func);
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    slot->update_hid_indicators = cache->update_hid_indicators_handle;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    split_central_prepare_subscription(
+        slot, &slot->batt_lvl_subscribe_params, cache->battery_level_handle,
+        cache->battery_level_ccc_handle, split_central_battery_level_notify_func);
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+    slot->handles_complete = true;
 
-    struct zmk_peripheral_battery_state_changed ev = {
-        .source = peripheral_slot_index_for_conn(conn), .state_of_charge = battery_level};
-    k_msgq_put(&peripheral_batt_lvl_msgq, &ev, K_NO_WAIT);
-    k_work_submit(&peripheral_batt_lvl_work);
+    // Position state is only subscribed to when there is no position events characteristic.
+    bool subscribed = split_central_subscribe_cached(
+        conn, slot->events_subscribe_params.value_handle ? &slot->events_subscribe_params
+                                                         : &slot->subscribe_params);
+#if ZMK_KEYMAP_HAS_SENSORS
+    subscribed = subscribed && split_central_subscribe_cached(
+                                   conn, slot->sensor_deltas_subscribe_params.value_handle
+                                             ? &slot->sensor_deltas_subscribe_params
+                                             : &slot->sensor_subscribe_params);
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    subscribed =
+        subscribed && split_central_subscribe_cached(conn, &slot->batt_lvl_subscribe_params);
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
 
-    return BT_GATT_ITER_CONTINUE;
-}
+    if (!subscribed) {
+        return false;
+    }
 
-#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+    if (slot->invoke_behavior_handle) {
+        split_central_read_behavior_table(conn, slot);
+    }
 
-static int split_central_subscribe(struct bt_conn *conn, struct bt_gatt_subscribe_params *params) {
-    int err = bt_gatt_subscribe(conn, params);
-    switch (err) {
-    case -EALREADY:
-        LOG_DBG("[ALREADY SUBSCRIBED]");
-        break;
-    case 0:
-        LOG_DBG("[SUBSCRIBED]");
-        break;
-    default:
-        LOG_ERR("Subscribe failed (err %d)", err);
-        break;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    if (slot->batt_lvl_subscribe_params.value_handle) {
+        split_central_read_battery_level(conn, slot);
     }
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
 
-    return err;
+    return true;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+
+static void split_central_handles_complete(struct peripheral_slot *slot) {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+    slot->handles_complete = true;
+    split_central_update_gatt_cache(slot);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
 }
 
 static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
@@ -396,6 +1206,27 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
                                                  struct bt_gatt_discover_params *params) {
     if (!attr) {
         LOG_DBG("Discover complete");
+
+        struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+        if (slot == NULL) {
+            return BT_GATT_ITER_STOP;
+        }
+
+        // Peripherals without the position events characteristic only send position bitmaps.
+        if (slot->subscribe_params.value_handle && !slot->events_subscribe_params.value_handle) {
+            split_central_subscribe(conn, &slot->subscribe_params);
+        }
+
+#if ZMK_KEYMAP_HAS_SENSORS
+        // Likewise, those without the sensor deltas characteristic only send sensor state.
+        if (slot->sensor_subscribe_params.value_handle &&
+            !slot->sensor_deltas_subscribe_params.value_handle) {
+            split_central_subscribe(conn, &slot->sensor_subscribe_params);
+        }
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+        split_central_handles_complete(slot);
+
         return BT_GATT_ITER_STOP;
     }
 
@@ -415,12 +1246,21 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
 
     if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_STATE_UUID)) == 0) {
         LOG_DBG("Found position state characteristic");
-        slot->subscribe_params.disc_params = &slot->sub_discover_params;
-        slot->subscribe_params.end_handle = slot->discover_params.end_handle;
-        slot->subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-        slot->subscribe_params.notify = split_central_notify_func;
-        slot->subscribe_params.value = BT_GATT_CCC_NOTIFY;
-        split_central_subscribe(conn, &slot->subscribe_params);
+        split_central_prepare_subscription(slot, &slot->subscribe_params,
+                                           bt_gatt_attr_value_handle(attr), 0,
+                                           split_central_notify_func);
+        // Only subscribed to once discovery shows there is no position events characteristic.
+    } else if (bt_uuid_cmp(chrc_uuid,
+                           BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID)) == 0) {
+        LOG_DBG("Found position events characteristic");
+        slot->discover_params.uuid = NULL;
+        slot->discover_params.start_handle = attr->handle + 2;
+        slot->discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+        split_central_prepare_subscription(slot, &slot->events_subscribe_params,
+                                           bt_gatt_attr_value_handle(attr), 0,
+                                           split_central_position_events_notify_func);
+        split_central_subscribe(conn, &slot->events_subscribe_params);
 #if ZMK_KEYMAP_HAS_SENSORS
     } else if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_SENSOR_STATE_UUID)) ==
                0) {
@@ -428,12 +1268,21 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
         slot->discover_params.start_handle = attr->handle + 2;
         slot->discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
 
-        slot->sensor_subscribe_params.disc_params = &slot->sub_discover_params;
-        slot->sensor_subscribe_params.end_handle = slot->discover_params.end_handle;
-        slot->sensor_subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-        slot->sensor_subscribe_params.notify = split_central_sensor_notify_func;
-        slot->sensor_subscribe_params.value = BT_GATT_CCC_NOTIFY;
-        split_central_subscribe(conn, &slot->sensor_subscribe_params);
+        split_central_prepare_subscription(slot, &slot->sensor_subscribe_params,
+                                           bt_gatt_attr_value_handle(attr), 0,
+                                           split_central_sensor_notify_func);
+        // Only subscribed to once discovery shows there is no sensor deltas characteristic.
+    } else if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_SENSOR_DELTAS_UUID)) ==
+               0) {
+        LOG_DBG("Found sensor deltas characteristic");
+        slot->discover_params.uuid = NULL;
+        slot->discover_params.start_handle = attr->handle + 2;
+        slot->discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+        split_central_prepare_subscription(slot, &slot->sensor_deltas_subscribe_params,
+                                           bt_gatt_attr_value_handle(attr), 0,
+                                           split_central_sensor_deltas_notify_func);
+        split_central_subscribe(conn, &slot->sensor_deltas_subscribe_params);
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
     } else if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_UUID)) ==
                0) {
@@ -441,6 +1290,11 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
         slot->discover_params.uuid = NULL;
         slot->discover_params.start_handle = attr->handle + 2;
         slot->run_behavior_handle = bt_gatt_attr_value_handle(attr);
+    } else if (bt_uuid_cmp(chrc_uuid,
+                           BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_INVOKE_BEHAVIOR_UUID)) == 0) {
+        LOG_DBG("Found invoke behavior handle");
+        slot->invoke_behavior_handle = bt_gatt_attr_value_handle(attr);
+        split_central_read_behavior_table(conn, slot);
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
                             BT_UUID_DECLARE_128(ZMK_SPLIT_BT_UPDATE_HID_INDICATORS_UUID))) {
@@ -451,25 +1305,21 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
     } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
                             BT_UUID_BAS_BATTERY_LEVEL)) {
         LOG_DBG("Found battery level characteristics");
-        slot->batt_lvl_subscribe_params.disc_params = &slot->sub_discover_params;
-        slot->batt_lvl_subscribe_params.end_handle = slot->discover_params.end_handle;
-        slot->batt_lvl_subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-        slot->batt_lvl_subscribe_params.notify = split_central_battery_level_notify_func;
-        slot->batt_lvl_subscribe_params.value = BT_GATT_CCC_NOTIFY;
+        split_central_prepare_subscription(slot, &slot->batt_lvl_subscribe_params,
+                                           bt_gatt_attr_value_handle(attr), 0,
+                                           split_central_battery_level_notify_func);
         split_central_subscribe(conn, &slot->batt_lvl_subscribe_params);
-
-        slot->batt_lvl_read_params.func = split_central_battery_level_read_func;
-        slot->batt_lvl_read_params.handle_count = 1;
-        slot->batt_lvl_read_params.single.handle = bt_gatt_attr_value_handle(attr);
-        slot->batt_lvl_read_params.single.offset = 0;
-        bt_gatt_read(conn, &slot->batt_lvl_read_params);
+        split_central_read_battery_level(conn, slot);
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
     }
 
-    bool subscribed = slot->run_behavior_handle && slot->subscribe_params.value_handle;
+    bool subscribed = slot->run_behavior_handle && slot->invoke_behavior_handle &&
+                      slot->subscribe_params.value_handle &&
+                      slot->events_subscribe_params.value_handle;
 
 #if ZMK_KEYMAP_HAS_SENSORS
-    subscribed = subscribed && slot->sensor_subscribe_params.value_handle;
+    subscribed = subscribed && slot->sensor_subscribe_params.value_handle &&
+                 slot->sensor_deltas_subscribe_params.value_handle;
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
@@ -479,7 +1329,13 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
     subscribed = subscribed && slot->batt_lvl_subscribe_params.value_handle;
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
 
-    return subscribed ? BT_GATT_ITER_STOP : BT_GATT_ITER_CONTINUE;
+    if (!subscribed) {
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    split_central_handles_complete(slot);
+
+    return BT_GATT_ITER_STOP;
 }
 
 static uint8_t split_central_service_discovery_func(struct bt_conn *conn,
@@ -517,6 +1373,82 @@ static uint8_t split_central_service_discovery_func(struct bt_conn *conn,
     return BT_GATT_ITER_STOP;
 }
 
+static int split_central_discover(struct bt_conn *conn, struct peripheral_slot *slot) {
+    LOG_DBG("Discovering the split service of peripheral %d", (int)(slot - peripherals));
+
+    slot->discover_params.uuid = &split_service_uuid.uuid;
+    slot->discover_params.func = split_central_service_discovery_func;
+    slot->discover_params.start_handle = 0x0001;
+    slot->discover_params.end_handle = 0xffff;
+    slot->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
+
+    int err = bt_gatt_discover(conn, &slot->discover_params);
+    if (err) {
+        LOG_ERR("Discover failed(err %d)", err);
+    }
+
+    return err;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+
+static uint8_t split_central_db_hash_read_func(struct bt_conn *conn, uint8_t err,
+                                               struct bt_gatt_read_params *params,
+                                               const void *data, uint16_t length) {
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+
+    if (!slot) {
+        LOG_ERR("No peripheral state found for connection");
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (err > 0 || !data || length != sizeof(slot->db_hash)) {
+        // Without a hash, there's no telling whether cached handles are still valid.
+        LOG_WRN("Peripheral GATT database hash unavailable (err %u), discovering", err);
+        split_central_discover(conn, slot);
+        return BT_GATT_ITER_STOP;
+    }
+
+    memcpy(slot->db_hash, data, sizeof(slot->db_hash));
+    slot->db_hash_valid = true;
+
+    const struct peripheral_gatt_cache *cache = &gatt_caches[slot - peripherals];
+
+    if (bt_addr_le_cmp(&cache->addr, bt_conn_get_dst(conn)) != 0 ||
+        memcmp(cache->db_hash, slot->db_hash, sizeof(slot->db_hash)) != 0 ||
+        !cache->position_state_handle) {
+        LOG_DBG("No cached GATT handles for peripheral %d, discovering",
+                (int)(slot - peripherals));
+        split_central_discover(conn, slot);
+        return BT_GATT_ITER_STOP;
+    }
+
+    LOG_DBG("Subscribing with cached GATT handles for peripheral %d", (int)(slot - peripherals));
+    if (!split_central_apply_gatt_cache(conn, slot, cache)) {
+        split_central_drop_gatt_cache(conn, slot);
+    }
+
+    return BT_GATT_ITER_STOP;
+}
+
+static int split_central_read_db_hash(struct bt_conn *conn, struct peripheral_slot *slot) {
+    slot->db_hash_read_params.func = split_central_db_hash_read_func;
+    slot->db_hash_read_params.handle_count = 0;
+    slot->db_hash_read_params.by_uuid.start_handle = 0x0001;
+    slot->db_hash_read_params.by_uuid.end_handle = 0xffff;
+    slot->db_hash_read_params.by_uuid.uuid = BT_UUID_GATT_DB_HASH;
+
+    int err = bt_gatt_read(conn, &slot->db_hash_read_params);
+    if (err) {
+        LOG_WRN("Failed to read peripheral GATT database hash (err %d)", err);
+        return split_central_discover(conn, slot);
+    }
+
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+
 static void split_central_process_connection(struct bt_conn *conn) {
     int err;
 
@@ -529,15 +1461,13 @@ static void split_central_process_connection(struct bt_conn *conn) {
     }
 
     if (!slot->subscribe_params.value_handle) {
-        slot->discover_params.uuid = &split_service_uuid.uuid;
-        slot->discover_params.func = split_central_service_discovery_func;
-        slot->discover_params.start_handle = 0x0001;
-        slot->discover_params.end_handle = 0xffff;
-        slot->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
-
-        err = bt_gatt_discover(slot->conn, &slot->discover_params);
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
+        // Continues with either the cached handles or discovery once the hash has been read.
+        err = split_central_read_db_hash(conn, slot);
+#else
+        err = split_central_discover(conn, slot);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE)
         if (err) {
-            LOG_ERR("Discover failed(err %d)", err);
             return;
         }
     }
@@ -546,13 +1476,140 @@ static void split_central_process_connection(struct bt_conn *conn) {
 
     bt_conn_get_info(conn, &info);
 
-    LOG_DBG("New connection params: Interval: %d, Latency: %d, PHY: %d", info.le.interval,
-            info.le.latency, info.le.phy->rx_phy);
+    LOG_DBG("New connection params: Interval: %d, Latency: %d, PHY: tx %d rx %d",
+            info.le.interval, info.le.latency, info.le.phy->tx_phy, info.le.phy->rx_phy);
 
     // Restart scanning if necessary.
     start_scanning();
 }
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MANAGER)
+
+/*
+ * The links to all peripherals drop their peripheral latency while keys are pressed on any half,
+ * so the central's messages reach the peripheral on the next connection event, and get it back
+ * once typing stops or the keyboard goes idle. The interval stays the same in both, since
+ * peripheral latency never delays the peripheral's own key presses. Updates for each peripheral
+ * are requested at most once per request interval.
+ */
+enum split_conn_param_profile {
+    SPLIT_CONN_PARAM_PROFILE_FAST,
+    SPLIT_CONN_PARAM_PROFILE_IDLE,
+};
+
+static const struct bt_le_conn_param split_conn_param_profiles[] = {
+    [SPLIT_CONN_PARAM_PROFILE_FAST] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_SPLIT_BLE_PREF_INT, CONFIG_ZMK_SPLIT_BLE_PREF_INT,
+        CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_FAST_LATENCY, CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT),
+    [SPLIT_CONN_PARAM_PROFILE_IDLE] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_SPLIT_BLE_PREF_INT, CONFIG_ZMK_SPLIT_BLE_PREF_INT,
+        CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_IDLE_LATENCY, CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT),
+};
+
+static enum split_conn_param_profile split_conn_param_desired = SPLIT_CONN_PARAM_PROFILE_FAST;
+static int64_t split_conn_param_last_request[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+
+static bool split_conn_param_applied(struct bt_conn *conn) {
+    const struct bt_le_conn_param *param = &split_conn_param_profiles[split_conn_param_desired];
+    struct bt_conn_info info;
+
+    bt_conn_get_info(conn, &info);
+
+    return info.le.interval >= param->interval_min && info.le.interval <= param->interval_max &&
+           info.le.latency == param->latency;
+}
+
+static void split_conn_param_update_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(split_conn_param_update_work, split_conn_param_update_callback);
+
+static void split_conn_param_update_callback(struct k_work *work) {
+    const struct bt_le_conn_param *param = &split_conn_param_profiles[split_conn_param_desired];
+    int64_t now = k_uptime_get();
+    int64_t recheck = -1;
+
+    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        struct peripheral_slot *slot = &peripherals[i];
+
+        if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED ||
+            split_conn_param_applied(slot->conn)) {
+            continue;
+        }
+
+        int64_t wait = split_conn_param_last_request[i] +
+                       CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MIN_REQUEST_INTERVAL_MS - now;
+        if (wait <= 0) {
+            LOG_DBG("Requesting %s split link parameters for peripheral %d: interval %d latency %d",
+                    split_conn_param_desired == SPLIT_CONN_PARAM_PROFILE_FAST ? "fast" : "idle", i,
+                    param->interval_min, param->latency);
+
+            int err = bt_conn_le_param_update(slot->conn, param);
+            if (err) {
+                LOG_WRN("Failed to update split link parameters (err %d)", err);
+            }
+
+            split_conn_param_last_request[i] = now;
+            // Checked again in case the update doesn't take.
+            wait = CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MIN_REQUEST_INTERVAL_MS;
+        }
+
+        recheck = recheck < 0 ? wait : MIN(recheck, wait);
+    }
+
+    if (recheck >= 0) {
+        k_work_reschedule(&split_conn_param_update_work, K_MSEC(recheck));
+    }
+}
+
+static void split_conn_param_set_desired(enum split_conn_param_profile profile) {
+    if (split_conn_param_desired == profile) {
+        return;
+    }
+
+    split_conn_param_desired = profile;
+    k_work_reschedule(&split_conn_param_update_work, K_NO_WAIT);
+}
+
+static void split_conn_param_hold_expired(struct k_work *work) {
+    split_conn_param_set_desired(SPLIT_CONN_PARAM_PROFILE_IDLE);
+}
+
+static K_WORK_DELAYABLE_DEFINE(split_conn_param_hold_work, split_conn_param_hold_expired);
+
+static void split_conn_param_note_activity(void) {
+    split_conn_param_set_desired(SPLIT_CONN_PARAM_PROFILE_FAST);
+    k_work_reschedule(&split_conn_param_hold_work,
+                      K_MSEC(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_FAST_HOLD_MS));
+}
+
+static int split_conn_param_listener(const zmk_event_t *eh) {
+    const struct zmk_activity_state_changed *activity_ev = as_zmk_activity_state_changed(eh);
+    if (activity_ev != NULL) {
+        if (activity_ev->state == ZMK_ACTIVITY_ACTIVE) {
+            split_conn_param_note_activity();
+        } else {
+            k_work_cancel_delayable(&split_conn_param_hold_work);
+            split_conn_param_set_desired(SPLIT_CONN_PARAM_PROFILE_IDLE);
+        }
+
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    // Presses on peripherals show up here too, once the central has received them.
+    const struct zmk_position_state_changed *position_ev = as_zmk_position_state_changed(eh);
+    if (position_ev != NULL && position_ev->state) {
+        split_conn_param_note_activity();
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(split_central_conn_param, split_conn_param_listener);
+ZMK_SUBSCRIPTION(split_central_conn_param, zmk_activity_state_changed);
+ZMK_SUBSCRIPTION(split_central_conn_param, zmk_position_state_changed);
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MANAGER)
+
 static int stop_scanning(void) {
     LOG_DBG("Stopping peripheral scanning");
     is_scanning = false;
@@ -586,9 +1643,16 @@ static bool split_central_eir_found(const bt_addr_le_t *addr) {
     }
 
     LOG_DBG("Initiating new connnection");
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MANAGER)
+    // Connect fast so discovery is quick. The link drops to idle parameters after the hold time.
+    const struct bt_le_conn_param *param =
+        &split_conn_param_profiles[SPLIT_CONN_PARAM_PROFILE_FAST];
+    split_conn_param_note_activity();
+#else
     struct bt_le_conn_param *param =
         BT_LE_CONN_PARAM(CONFIG_ZMK_SPLIT_BLE_PREF_INT, CONFIG_ZMK_SPLIT_BLE_PREF_INT,
                          CONFIG_ZMK_SPLIT_BLE_PREF_LATENCY, CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MANAGER)
     err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, param, &slot->conn);
     if (err < 0) {
         LOG_ERR("Create conn failed (err %d) (create conn? 0x%04x)", err, BT_HCI_OP_LE_CREATE_CONN);
@@ -738,9 +1802,63 @@ static void split_central_disconnected(struct bt_conn *conn, uint8_t reason) {
     start_scanning();
 }
 
+static void split_central_security_changed(struct bt_conn *conn, bt_security_t level,
+                                           enum bt_security_err err) {
+    struct bt_conn_info info;
+
+    bt_conn_get_info(conn, &info);
+
+    if (info.role != BT_CONN_ROLE_CENTRAL || err) {
+        return;
+    }
+
+    if (peripheral_slot_for_conn(conn) == NULL) {
+        return;
+    }
+
+    zmk_ble_request_link_upgrade(conn);
+}
+
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+
+static void split_central_le_phy_updated(struct bt_conn *conn,
+                                         struct bt_conn_le_phy_info *param) {
+    if (peripheral_slot_for_conn(conn) == NULL) {
+        return;
+    }
+
+    LOG_DBG("Split peripheral PHY updated: tx %d rx %d", param->tx_phy, param->rx_phy);
+}
+
+#endif // IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MANAGER)
+
+static void split_central_le_param_updated(struct bt_conn *conn, uint16_t interval,
+                                           uint16_t latency, uint16_t timeout) {
+    if (peripheral_slot_for_conn(conn) == NULL) {
+        return;
+    }
+
+    LOG_DBG("Split link parameters updated: interval %d latency %d timeout %d", interval, latency,
+            timeout);
+
+    // The desired parameters may have changed while the update was in progress.
+    k_work_reschedule(&split_conn_param_update_work, K_NO_WAIT);
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MANAGER)
+
 static struct bt_conn_cb conn_callbacks = {
     .connected = split_central_connected,
     .disconnected = split_central_disconnected,
+    .security_changed = split_central_security_changed,
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+    .le_phy_updated = split_central_le_phy_updated,
+#endif // IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MANAGER)
+    .le_param_updated = split_central_le_param_updated,
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CONN_PARAM_MANAGER)
 };
 
 K_THREAD_STACK_DEFINE(split_central_split_run_q_stack,
@@ -748,35 +1866,79 @@ K_THREAD_STACK_DEFINE(split_central_split_run_q_stack,
 
 struct k_work_q split_central_split_run_q;
 
+/*
+ * Behaviors are queued by local ID. Their name is only looked up and copied into the name based
+ * payload when the peripheral can't be sent the ID.
+ */
 struct zmk_split_run_behavior_payload_wrapper {
     uint8_t source;
-    struct zmk_split_run_behavior_payload payload;
+    uint16_t behavior_id;
+    // Full binding position, the name based payload only has room for eight bits.
+    uint16_t position;
+    struct zmk_split_run_behavior_data data;
 };
 
 K_MSGQ_DEFINE(zmk_split_central_split_run_msgq,
               sizeof(struct zmk_split_run_behavior_payload_wrapper),
               CONFIG_ZMK_SPLIT_BLE_CENTRAL_SPLIT_RUN_QUEUE_SIZE, 4);
 
+static int
+split_central_invoke_behavior_by_id(struct peripheral_slot *slot,
+                                    struct zmk_split_run_behavior_payload_wrapper *wrapper) {
+    struct zmk_split_invoke_behavior_data data = {
+        .behavior_id = sys_cpu_to_le16(wrapper->behavior_id),
+        .position = sys_cpu_to_le16(wrapper->position),
+        .state = wrapper->data.state,
+        .param1 = sys_cpu_to_le32(wrapper->data.param1),
+        .param2 = sys_cpu_to_le32(wrapper->data.param2),
+    };
+
+    return bt_gatt_write_without_response(slot->conn, slot->invoke_behavior_handle, &data,
+                                          sizeof(data), true);
+}
+
+static int
+split_central_run_behavior_by_name(struct peripheral_slot *slot,
+                                   struct zmk_split_run_behavior_payload_wrapper *wrapper) {
+    const struct device *behavior = zmk_behavior_get_binding_by_local_id(wrapper->behavior_id);
+    if (behavior == NULL) {
+        return -ENODEV;
+    }
+
+    struct zmk_split_run_behavior_payload payload = {.data = wrapper->data};
+    const size_t payload_dev_size = sizeof(payload.behavior_dev);
+    if (strlcpy(payload.behavior_dev, behavior->name, payload_dev_size) >= payload_dev_size) {
+        LOG_ERR("Truncated behavior label %s to %s before invoking peripheral behavior",
+                behavior->name, payload.behavior_dev);
+    }
+
+    return bt_gatt_write_without_response(slot->conn, slot->run_behavior_handle, &payload,
+                                          sizeof(payload), true);
+}
+
 void split_central_split_run_callback(struct k_work *work) {
     struct zmk_split_run_behavior_payload_wrapper payload_wrapper;
 
     LOG_DBG("");
 
     while (k_msgq_get(&zmk_split_central_split_run_msgq, &payload_wrapper, K_NO_WAIT) == 0) {
-        if (peripherals[payload_wrapper.source].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+        struct peripheral_slot *slot = &peripherals[payload_wrapper.source];
+
+        if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED) {
             LOG_ERR("Source not connected");
             continue;
         }
-        if (!peripherals[payload_wrapper.source].run_behavior_handle) {
+
+        int err;
+        if (slot->behavior_table_matches && slot->invoke_behavior_handle) {
+            err = split_central_invoke_behavior_by_id(slot, &payload_wrapper);
+        } else if (slot->run_behavior_handle) {
+            err = split_central_run_behavior_by_name(slot, &payload_wrapper);
+        } else {
             LOG_ERR("Run behavior handle not found");
             continue;
         }
 
-        int err = bt_gatt_write_without_response(
-            peripherals[payload_wrapper.source].conn,
-            peripherals[payload_wrapper.source].run_behavior_handle, &payload_wrapper.payload,
-            sizeof(struct zmk_split_run_behavior_payload), true);
-
         if (err) {
             LOG_ERR("Failed to write the behavior characteristic (err %d)", err);
         }
@@ -809,22 +1971,27 @@ split_bt_invoke_behavior_payload(struct zmk_split_run_behavior_payload_wrapper p
     return 0;
 };
 
-int zmk_split_bt_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
-                                 struct zmk_behavior_binding_event event, bool state) {
-    struct zmk_split_run_behavior_payload payload = {.data = {
-                                                         .param1 = binding->param1,
-                                                         .param2 = binding->param2,
-                                                         .position = event.position,
-                                                         .state = state ? 1 : 0,
-                                                     }};
-    const size_t payload_dev_size = sizeof(payload.behavior_dev);
-    if (strlcpy(payload.behavior_dev, binding->behavior_dev, payload_dev_size) >=
-        payload_dev_size) {
-        LOG_ERR("Truncated behavior label %s to %s before invoking peripheral behavior",
-                binding->behavior_dev, payload.behavior_dev);
+int zmk_split_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
+                              struct zmk_behavior_binding_event event, bool state) {
+    int behavior_id = zmk_behavior_get_local_id(binding->behavior_dev);
+    if (behavior_id < 0) {
+        LOG_ERR("Behavior %s can't be invoked on a peripheral (err %d)", binding->behavior_dev,
+                behavior_id);
+        return behavior_id;
     }
 
-    struct zmk_split_run_behavior_payload_wrapper wrapper = {.source = source, .payload = payload};
+    struct zmk_split_run_behavior_payload_wrapper wrapper = {
+        .source = source,
+        .behavior_id = behavior_id,
+        .position = event.position,
+        .data =
+            {
+                .param1 = binding->param1,
+                .param2 = binding->param2,
+                .position = event.position,
+                .state = state ? 1 : 0,
+            },
+    };
     return split_bt_invoke_behavior_payload(wrapper);
 }
 
@@ -858,7 +2025,7 @@ static void split_central_update_indicators_callback(struct k_work *work) {
 
 static K_WORK_DEFINE(split_central_update_indicators, split_central_update_indicators_callback);
 
-int zmk_split_bt_update_hid_indicator(zmk_hid_indicators_t indicators) {
+int zmk_split_update_hid_indicator(zmk_hid_indicators_t indicators) {
     hid_indicators = indicators;
     return k_work_submit_to_queue(&split_central_split_run_q, &split_central_update_indicators);
 }
@@ -871,6 +2038,17 @@ static int zmk_split_bt_central_init(void) {
                        CONFIG_ZMK_BLE_THREAD_PRIORITY, NULL);
     bt_conn_cb_register(&conn_callbacks);
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE) && IS_ENABLED(CONFIG_SETTINGS)
+    settings_subsys_init();
+
+    int err = settings_register(&gatt_cache_handler);
+    if (err) {
+        LOG_ERR("Failed to setup the peripheral GATT cache settings handler (err %d)", err);
+    } else {
+        settings_load_subtree("split");
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_GATT_CACHE) && IS_ENABLED(CONFIG_SETTINGS)
+
     return IS_ENABLED(CONFIG_ZMK_BLE_CLEAR_BONDS_ON_START) ? 0 : start_scanning();
 }
 
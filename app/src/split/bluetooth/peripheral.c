@@ -123,10 +123,13 @@ static void security_changed(struct bt_conn *conn, bt_security_t level, enum bt_
 static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
                              uint16_t timeout) {
     char addr[BT_ADDR_LE_STR_LEN];
+    struct bt_conn_info info;
 
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
+    bt_conn_get_info(conn, &info);
 
-    LOG_DBG("%s: interval %d latency %d timeout %d", addr, interval, latency, timeout);
+    LOG_DBG("%s: interval %d latency %d timeout %d, PHY tx %d rx %d", addr, interval, latency,
+            timeout, info.le.phy->tx_phy, info.le.phy->rx_phy);
 }
 
 static struct bt_conn_cb conn_callbacks = {
@@ -7,12 +7,14 @@
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/types.h>
 #include <zephyr/sys/util.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/init.h>
 
 #include <zephyr/logging/log.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+#include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/uuid.h>
 
@@ -21,6 +23,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/matrix.h>
 #include <zmk/split/bluetooth/uuid.h>
 #include <zmk/split/bluetooth/service.h>
+#include <zmk/split/peripheral.h>
 
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
 #include <zmk/events/hid_indicators_changed.h>
@@ -28,6 +31,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/events/sensor_event.h>
 #include <zmk/sensors.h>
+#include <zmk/sensor_delta.h>
 
 #if ZMK_KEYMAP_HAS_SENSORS
 static struct sensor_event last_sensor_event;
@@ -41,12 +45,22 @@ static ssize_t split_svc_sensor_state(struct bt_conn *conn, const struct bt_gatt
 static void split_svc_sensor_state_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
     LOG_DBG("value %d", value);
 }
-#endif /* ZMK_KEYMAP_HAS_SENSORS */
 
-#define POS_STATE_LEN 16
+static bool sensor_deltas_notify_enabled;
+
+// Set while a sensor deltas notification is being sent.
+static atomic_t sensor_deltas_in_flight;
 
-static uint8_t num_of_positions = ZMK_KEYMAP_LEN;
-static uint8_t position_state[POS_STATE_LEN];
+static void split_svc_sensor_deltas_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
+    LOG_DBG("value %d", value);
+    sensor_deltas_notify_enabled = value == BT_GATT_CCC_NOTIFY;
+    // A notification cut short by a disconnect must not hold back those of the next connection.
+    atomic_clear(&sensor_deltas_in_flight);
+}
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+static uint16_t num_of_positions = ZMK_KEYMAP_LEN;
+static uint8_t position_state[ZMK_SPLIT_POS_STATE_LEN];
 
 static struct zmk_split_run_behavior_payload behavior_run_payload;
 
@@ -101,15 +115,75 @@ static ssize_t split_svc_run_behavior(struct bt_conn *conn, const struct bt_gatt
     return len;
 }
 
+static ssize_t split_svc_behavior_table_hash(struct bt_conn *conn,
+                                             const struct bt_gatt_attr *attrs, void *buf,
+                                             uint16_t len, uint16_t offset) {
+    uint32_t hash = sys_cpu_to_le32(zmk_behavior_get_table_hash());
+
+    return bt_gatt_attr_read(conn, attrs, buf, len, offset, &hash, sizeof(hash));
+}
+
+static ssize_t split_svc_invoke_behavior(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
+                                         const void *buf, uint16_t len, uint16_t offset,
+                                         uint8_t flags) {
+    struct zmk_split_invoke_behavior_data data;
+
+    if (offset != 0 || len != sizeof(data)) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    memcpy(&data, buf, sizeof(data));
+
+    uint16_t behavior_id = sys_le16_to_cpu(data.behavior_id);
+    const struct device *behavior = zmk_behavior_get_binding_by_local_id(behavior_id);
+    if (behavior == NULL) {
+        LOG_ERR("Unknown behavior ID %d", behavior_id);
+        return len;
+    }
+
+    struct zmk_behavior_binding binding = {
+        .param1 = sys_le32_to_cpu(data.param1),
+        .param2 = sys_le32_to_cpu(data.param2),
+        .behavior_dev = (char *)behavior->name,
+    };
+    LOG_DBG("%s with params %d %d: pressed? %d", binding.behavior_dev, binding.param1,
+            binding.param2, data.state);
+    struct zmk_behavior_binding_event event = {.position = sys_le16_to_cpu(data.position),
+                                               .timestamp = k_uptime_get()};
+    int err;
+    if (data.state > 0) {
+        err = behavior_keymap_binding_pressed(&binding, event);
+    } else {
+        err = behavior_keymap_binding_released(&binding, event);
+    }
+
+    if (err) {
+        LOG_ERR("Failed to invoke behavior %s: %d", binding.behavior_dev, err);
+    }
+
+    return len;
+}
+
 static ssize_t split_svc_num_of_positions(struct bt_conn *conn, const struct bt_gatt_attr *attrs,
                                           void *buf, uint16_t len, uint16_t offset) {
-    return bt_gatt_attr_read(conn, attrs, buf, len, offset, attrs->user_data, sizeof(uint8_t));
+    uint16_t value = sys_cpu_to_le16(*(uint16_t *)attrs->user_data);
+
+    // Reported as a single byte, as the descriptor is defined, unless there are too many keys.
+    return bt_gatt_attr_read(conn, attrs, buf, len, offset, &value,
+                             num_of_positions > UINT8_MAX ? sizeof(uint16_t) : sizeof(uint8_t));
 }
 
+static bool position_events_notify_enabled;
+
 static void split_svc_pos_state_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
     LOG_DBG("value %d", value);
 }
 
+static void split_svc_pos_events_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
+    LOG_DBG("value %d", value);
+    position_events_notify_enabled = value == BT_GATT_CCC_NOTIFY;
+}
+
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
 
 static zmk_hid_indicators_t hid_indicators = 0;
@@ -144,6 +218,9 @@ BT_GATT_SERVICE_DEFINE(
                            BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_READ_ENCRYPT,
                            split_svc_pos_state, NULL, &position_state),
     BT_GATT_CCC(split_svc_pos_state_ccc, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID),
+                           BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_NONE, NULL, NULL, NULL),
+    BT_GATT_CCC(split_svc_pos_events_ccc, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
     BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_UUID),
                            BT_GATT_CHRC_WRITE_WITHOUT_RESP, BT_GATT_PERM_WRITE_ENCRYPT, NULL,
                            split_svc_run_behavior, &behavior_run_payload),
@@ -154,23 +231,31 @@ BT_GATT_SERVICE_DEFINE(
                            BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_READ_ENCRYPT,
                            split_svc_sensor_state, NULL, &last_sensor_event),
     BT_GATT_CCC(split_svc_sensor_state_ccc, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_SENSOR_DELTAS_UUID),
+                           BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_NONE, NULL, NULL, NULL),
+    BT_GATT_CCC(split_svc_sensor_deltas_ccc,
+                BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_UPDATE_HID_INDICATORS_UUID),
                            BT_GATT_CHRC_WRITE_WITHOUT_RESP, BT_GATT_PERM_WRITE_ENCRYPT, NULL,
                            split_svc_update_indicators, NULL),
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_INVOKE_BEHAVIOR_UUID),
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                           BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT,
+                           split_svc_behavior_table_hash, split_svc_invoke_behavior, NULL),
 );
 
 K_THREAD_STACK_DEFINE(service_q_stack, CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_STACK_SIZE);
 
 struct k_work_q service_work_q;
 
-K_MSGQ_DEFINE(position_state_msgq, sizeof(char[POS_STATE_LEN]),
+K_MSGQ_DEFINE(position_state_msgq, sizeof(char[ZMK_SPLIT_POS_STATE_LEN]),
               CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE, 4);
 
 void send_position_state_callback(struct k_work *work) {
-    uint8_t state[POS_STATE_LEN];
+    uint8_t state[ZMK_SPLIT_POS_STATE_LEN];
 
     while (k_msgq_get(&position_state_msgq, &state, K_NO_WAIT) == 0) {
         int err = bt_gatt_notify(NULL, &split_svc.attrs[1], &state, sizeof(state));
@@ -188,7 +273,7 @@ int send_position_state() {
         switch (err) {
         case -EAGAIN: {
             LOG_WRN("Position state message queue full, popping first message and queueing again");
-            uint8_t discarded_state[POS_STATE_LEN];
+            uint8_t discarded_state[ZMK_SPLIT_POS_STATE_LEN];
             k_msgq_get(&position_state_msgq, &discarded_state, K_NO_WAIT);
             return send_position_state();
         }
@@ -203,14 +288,131 @@ int send_position_state() {
     return 0;
 }
 
-int zmk_split_bt_position_pressed(uint8_t position) {
-    WRITE_BIT(position_state[position / 8], position % 8, true);
+/*
+ * Centrals that subscribe to the position events characteristic get compact records of each
+ * change instead of the full bitmap. Changes that pile up while the link is busy are sent
+ * together in one notification.
+ */
+struct position_event {
+    uint32_t position;
+    bool pressed;
+    int64_t timestamp;
+};
+
+K_MSGQ_DEFINE(position_event_msgq, sizeof(struct position_event),
+              CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE, 4);
+
+static uint8_t position_events_sequence;
+static atomic_t position_events_dropped;
+
+// The smallest ATT MTU of the connections, or 0 if none is ready yet.
+static void position_events_min_mtu(struct bt_conn *conn, void *data) {
+    uint16_t *min_mtu = data;
+    uint16_t mtu = bt_gatt_get_mtu(conn);
+
+    if (mtu > 0 && (*min_mtu == 0 || mtu < *min_mtu)) {
+        *min_mtu = mtu;
+    }
+}
+
+static size_t position_events_per_notification(void) {
+    uint16_t mtu = 0;
+
+    bt_conn_foreach(BT_CONN_TYPE_LE, position_events_min_mtu, &mtu);
+
+    // Notifications carry up to the ATT MTU minus the 3 byte notification header.
+    size_t fits = mtu > 3 + sizeof(struct zmk_split_position_events)
+                      ? (mtu - 3 - sizeof(struct zmk_split_position_events)) /
+                            sizeof(struct zmk_split_position_event)
+                      : 0;
+
+    return CLAMP(fits, 1, CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_EVENTS_PER_NOTIFICATION);
+}
+
+void send_position_events_callback(struct k_work *work) {
+    uint8_t buf[sizeof(struct zmk_split_position_events) +
+                CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_EVENTS_PER_NOTIFICATION *
+                    sizeof(struct zmk_split_position_event)];
+    struct zmk_split_position_events *payload = (struct zmk_split_position_events *)buf;
+    struct position_event ev;
+    size_t max_count = position_events_per_notification();
+
+    while (k_msgq_num_used_get(&position_event_msgq) > 0) {
+        // Skip the sequence numbers of dropped events so the central notices the gap.
+        position_events_sequence += atomic_clear(&position_events_dropped);
+        payload->sequence = position_events_sequence;
+
+        int64_t now = k_uptime_get();
+        payload->timestamp = sys_cpu_to_le32((uint32_t)now);
+        size_t count = 0;
+        while (count < max_count &&
+               k_msgq_get(&position_event_msgq, &ev, K_NO_WAIT) == 0) {
+            uint16_t age = CLAMP(now - ev.timestamp, 0, ZMK_SPLIT_POSITION_EVENT_AGE_MAX);
+
+            payload->events[count].position = sys_cpu_to_le16(ev.position);
+            payload->events[count].state_age =
+                sys_cpu_to_le16(age | (ev.pressed ? ZMK_SPLIT_POSITION_EVENT_PRESSED : 0));
+            count++;
+        }
+
+        if (count == 0) {
+            break;
+        }
+
+        position_events_sequence += count;
+
+        int err = bt_gatt_notify(NULL, &split_svc.attrs[5], buf,
+                                 sizeof(struct zmk_split_position_events) +
+                                     count * sizeof(struct zmk_split_position_event));
+        if (err) {
+            LOG_DBG("Error notifying %d", err);
+        }
+    }
+}
+
+K_WORK_DEFINE(service_position_events_notify_work, send_position_events_callback);
+
+static int send_position_event(uint32_t position, bool pressed, int64_t timestamp) {
+    struct position_event ev = {.position = position, .pressed = pressed, .timestamp = timestamp};
+
+    int err = k_msgq_put(&position_event_msgq, &ev, K_MSEC(100));
+    if (err) {
+        switch (err) {
+        case -EAGAIN: {
+            LOG_WRN("Position event message queue full, popping first message and queueing again");
+            struct position_event discarded_ev;
+            if (k_msgq_get(&position_event_msgq, &discarded_ev, K_NO_WAIT) == 0) {
+                atomic_inc(&position_events_dropped);
+            }
+            return send_position_event(position, pressed, timestamp);
+        }
+        default:
+            LOG_WRN("Failed to queue position event to send (%d)", err);
+            return err;
+        }
+    }
+
+    k_work_submit_to_queue(&service_work_q, &service_position_events_notify_work);
+
+    return 0;
+}
+
+static int send_position_update(uint32_t position, bool pressed, int64_t timestamp) {
+    if (position_events_notify_enabled) {
+        return send_position_event(position, pressed, timestamp);
+    }
+
     return send_position_state();
 }
 
-int zmk_split_bt_position_released(uint8_t position) {
+int zmk_split_position_pressed(uint32_t position, int64_t timestamp) {
+    WRITE_BIT(position_state[position / 8], position % 8, true);
+    return send_position_update(position, true, timestamp);
+}
+
+int zmk_split_position_released(uint32_t position, int64_t timestamp) {
     WRITE_BIT(position_state[position / 8], position % 8, false);
-    return send_position_state();
+    return send_position_update(position, false, timestamp);
 }
 
 #if ZMK_KEYMAP_HAS_SENSORS
@@ -219,7 +421,7 @@ K_MSGQ_DEFINE(sensor_state_msgq, sizeof(struct sensor_event),
 
 void send_sensor_state_callback(struct k_work *work) {
     while (k_msgq_get(&sensor_state_msgq, &last_sensor_event, K_NO_WAIT) == 0) {
-        int err = bt_gatt_notify(NULL, &split_svc.attrs[8], &last_sensor_event,
+        int err = bt_gatt_notify(NULL, &split_svc.attrs[11], &last_sensor_event,
                                  sizeof(last_sensor_event));
         if (err) {
             LOG_DBG("Error notifying %d", err);
@@ -250,13 +452,179 @@ int send_sensor_state(struct sensor_event ev) {
     return 0;
 }
 
-int zmk_split_bt_sensor_triggered(uint8_t sensor_index,
-                                  const struct zmk_sensor_channel_data channel_data[],
-                                  size_t channel_data_size) {
+/*
+ * Centrals that subscribe to the sensor deltas characteristic get the net change of each sensor
+ * instead of every reading. Readings are accumulated per sensor while the previous notification
+ * is still being sent, so a fast spinning encoder takes up one record per notification rather than
+ * one queue entry per step, and no steps are lost to a full queue.
+ */
+struct sensor_delta {
+    size_t channel_count;
+    struct zmk_sensor_delta channels[ZMK_SENSOR_EVENT_MAX_CHANNELS];
+};
+
+static struct sensor_delta sensor_deltas[ZMK_KEYMAP_SENSORS_LEN];
+
+// Protects sensor_deltas.
+static struct k_spinlock sensor_deltas_lock;
+
+// Sensor to start the next notification at, so a busy sensor can't crowd out the others.
+static size_t sensor_deltas_next;
+
+static struct zmk_sensor_delta *sensor_delta_channel(struct sensor_delta *delta,
+                                                     enum sensor_channel channel) {
+    for (size_t i = 0; i < delta->channel_count; i++) {
+        if (delta->channels[i].channel == channel) {
+            return &delta->channels[i];
+        }
+    }
+
+    if (delta->channel_count == ZMK_SENSOR_EVENT_MAX_CHANNELS) {
+        return NULL;
+    }
+
+    delta->channels[delta->channel_count] = (struct zmk_sensor_delta){.channel = channel};
+    return &delta->channels[delta->channel_count++];
+}
+
+static void sensor_deltas_add(uint8_t sensor_index,
+                              const struct zmk_sensor_channel_data channel_data[],
+                              size_t channel_data_size) {
+    k_spinlock_key_t key = k_spin_lock(&sensor_deltas_lock);
+
+    for (size_t i = 0; i < channel_data_size; i++) {
+        struct zmk_sensor_delta *channel =
+            sensor_delta_channel(&sensor_deltas[sensor_index], channel_data[i].channel);
+
+        if (channel != NULL) {
+            zmk_sensor_delta_add(channel, &channel_data[i].value);
+        }
+    }
+
+    k_spin_unlock(&sensor_deltas_lock, key);
+}
+
+// Takes the deltas out of a notification once it has been queued, keeping any readings added
+// since it was built.
+static void sensor_deltas_remove_sent(const struct zmk_split_sensor_delta sent[], size_t count) {
+    k_spinlock_key_t key = k_spin_lock(&sensor_deltas_lock);
+
+    for (size_t i = 0; i < count; i++) {
+        struct zmk_sensor_delta *channel = sensor_delta_channel(
+            &sensor_deltas[sent[i].sensor_index], sys_le16_to_cpu(sent[i].channel));
+        const struct sensor_value value = {.val1 = sys_le32_to_cpu(sent[i].val1),
+                                           .val2 = sys_le32_to_cpu(sent[i].val2)};
+
+        zmk_sensor_delta_sent(channel, &value);
+    }
+
+    k_spin_unlock(&sensor_deltas_lock, key);
+}
+
+static size_t sensor_deltas_per_notification(void) {
+    uint16_t mtu = 0;
+
+    bt_conn_foreach(BT_CONN_TYPE_LE, position_events_min_mtu, &mtu);
+
+    size_t fits = mtu > 3 ? (mtu - 3) / sizeof(struct zmk_split_sensor_delta) : 0;
+
+    // All channels of a sensor are always sent together.
+    return CLAMP(fits, ZMK_SENSOR_EVENT_MAX_CHANNELS,
+                 ZMK_KEYMAP_SENSORS_LEN * ZMK_SENSOR_EVENT_MAX_CHANNELS);
+}
+
+static void send_sensor_deltas_callback(struct k_work *work);
+
+K_WORK_DEFINE(service_sensor_deltas_notify_work, send_sensor_deltas_callback);
+
+static void sensor_deltas_sent(struct bt_conn *conn, void *user_data) {
+    atomic_clear(&sensor_deltas_in_flight);
+    k_work_submit_to_queue(&service_work_q, &service_sensor_deltas_notify_work);
+}
+
+static void send_sensor_deltas_callback(struct k_work *work) {
+    // Only one notification is in flight at a time. Whatever accumulates meanwhile goes out in
+    // the next one, once the link has room for it.
+    if (atomic_set(&sensor_deltas_in_flight, 1)) {
+        return;
+    }
+
+    struct zmk_split_sensor_delta buf[ZMK_KEYMAP_SENSORS_LEN * ZMK_SENSOR_EVENT_MAX_CHANNELS];
+    size_t max_count = sensor_deltas_per_notification();
+    size_t count = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&sensor_deltas_lock);
+
+    for (size_t n = 0; n < ZMK_KEYMAP_SENSORS_LEN; n++) {
+        size_t sensor_index = (sensor_deltas_next + n) % ZMK_KEYMAP_SENSORS_LEN;
+        struct sensor_delta *delta = &sensor_deltas[sensor_index];
+        struct sensor_value values[ZMK_SENSOR_EVENT_MAX_CHANNELS];
+        bool pending = false;
+
+        for (size_t i = 0; i < delta->channel_count; i++) {
+            pending |= zmk_sensor_delta_get(&delta->channels[i], &values[i]);
+        }
+
+        if (!pending) {
+            continue;
+        }
+
+        if (count + delta->channel_count > max_count) {
+            sensor_deltas_next = sensor_index;
+            break;
+        }
+
+        for (size_t i = 0; i < delta->channel_count; i++) {
+            buf[count].sensor_index = sensor_index;
+            buf[count].channel = sys_cpu_to_le16(delta->channels[i].channel);
+            buf[count].val1 = sys_cpu_to_le32(values[i].val1);
+            buf[count].val2 = sys_cpu_to_le32(values[i].val2);
+            count++;
+        }
+    }
+
+    k_spin_unlock(&sensor_deltas_lock, key);
+
+    if (count == 0) {
+        atomic_clear(&sensor_deltas_in_flight);
+        return;
+    }
+
+    struct bt_gatt_notify_params params = {
+        .attr = &split_svc.attrs[14],
+        .data = buf,
+        .len = count * sizeof(struct zmk_split_sensor_delta),
+        .func = sensor_deltas_sent,
+    };
+
+    int err = bt_gatt_notify_cb(NULL, &params);
+    if (err) {
+        // The deltas stay accumulated and go out with the next reading.
+        LOG_DBG("Error notifying %d", err);
+        atomic_clear(&sensor_deltas_in_flight);
+        return;
+    }
+
+    sensor_deltas_remove_sent(buf, count);
+}
+
+int zmk_split_sensor_triggered(uint8_t sensor_index,
+                               const struct zmk_sensor_channel_data channel_data[],
+                               size_t channel_data_size) {
     if (channel_data_size > ZMK_SENSOR_EVENT_MAX_CHANNELS) {
         return -EINVAL;
     }
 
+    if (sensor_deltas_notify_enabled) {
+        if (sensor_index >= ZMK_KEYMAP_SENSORS_LEN) {
+            return -EINVAL;
+        }
+
+        sensor_deltas_add(sensor_index, channel_data, channel_data_size);
+        k_work_submit_to_queue(&service_work_q, &service_sensor_deltas_notify_work);
+        return 0;
+    }
+
     struct sensor_event ev =
         (struct sensor_event){.sensor_index = sensor_index, .channel_data_size = channel_data_size};
     memcpy(ev.channel_data, channel_data,
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_split_loopback
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/behavior.h>
+#include <zmk/matrix.h>
+#include <zmk/matrix_transform.h>
+#include <zmk/split/central.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/keycode_state_changed.h>
+#include <zmk/events/position_state_changed.h>
+
+BUILD_ASSERT(DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT) == 1,
+             "Exactly one zmk,split-loopback node must be enabled");
+
+/*
+ * The simulated peripheral lives in the central image. Its key events take the same path as
+ * those of a real peripheral, except that the link is a pair of queues which hold each message
+ * back for the configured latency, jitter and retransmissions. Messages are delivered in order.
+ *
+ * Everything here runs on the system work queue, which is where kscan_mock calls back from.
+ */
+
+#define PERIPHERAL_SOURCE 0
+#define LATENCY_BUCKETS (CONFIG_ZMK_SPLIT_LOOPBACK_LATENCY_HISTOGRAM_MS + 1)
+
+enum loopback_message_type {
+    LOOPBACK_MSG_POSITION,
+    LOOPBACK_MSG_INVOKE_BEHAVIOR,
+};
+
+struct loopback_message {
+    enum loopback_message_type type;
+    int64_t deliver_at;
+    union {
+        struct zmk_position_state_changed position;
+        struct {
+            struct zmk_behavior_binding binding;
+            struct zmk_behavior_binding_event event;
+            bool state;
+        } behavior;
+    };
+};
+
+struct loopback_link {
+    const char *name;
+    struct loopback_message queue[CONFIG_ZMK_SPLIT_LOOPBACK_QUEUE_SIZE];
+    size_t head;
+    size_t count;
+    int64_t last_deliver_at;
+    uint32_t overflows;
+    struct k_work_delayable work;
+    void (*deliver)(const struct loopback_message *msg);
+};
+
+static uint32_t random_state = CONFIG_ZMK_SPLIT_LOOPBACK_RANDOM_SEED;
+
+// xorshift32, so a given seed always produces the same jitter and loss pattern.
+static uint32_t next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static uint32_t link_delay(void) {
+    uint32_t delay = CONFIG_ZMK_SPLIT_LOOPBACK_LATENCY_MS;
+
+    if (CONFIG_ZMK_SPLIT_LOOPBACK_JITTER_MS > 0) {
+        delay += next_random() % (CONFIG_ZMK_SPLIT_LOOPBACK_JITTER_MS + 1);
+    }
+
+    while (CONFIG_ZMK_SPLIT_LOOPBACK_LOSS_PERCENT > 0 &&
+           next_random() % 100 < CONFIG_ZMK_SPLIT_LOOPBACK_LOSS_PERCENT) {
+        delay += CONFIG_ZMK_SPLIT_LOOPBACK_RETRANSMIT_INTERVAL_MS;
+    }
+
+    return delay;
+}
+
+static void link_schedule(struct loopback_link *link, int64_t now) {
+    int64_t deliver_at = link->queue[link->head].deliver_at;
+
+    k_work_schedule(&link->work, deliver_at > now ? K_TIMEOUT_ABS_MS(deliver_at) : K_NO_WAIT);
+}
+
+static void link_deliver_head(struct loopback_link *link) {
+    struct loopback_message msg = link->queue[link->head];
+
+    link->head = (link->head + 1) % CONFIG_ZMK_SPLIT_LOOPBACK_QUEUE_SIZE;
+    link->count--;
+    link->deliver(&msg);
+}
+
+static void link_send(struct loopback_link *link, struct loopback_message *msg) {
+    int64_t now = k_uptime_get();
+
+    // Messages are never lost, so a full queue makes room by delivering its oldest message early,
+    // which understates that message's latency.
+    if (link->count == CONFIG_ZMK_SPLIT_LOOPBACK_QUEUE_SIZE) {
+        link->overflows++;
+        LOG_WRN("%s link queue full, delivering oldest message %d ms early (overflow %u)",
+                link->name, (int)(link->queue[link->head].deliver_at - now), link->overflows);
+        link_deliver_head(link);
+    }
+
+    // A message can't overtake the one sent before it.
+    msg->deliver_at = MAX(now + link_delay(), link->last_deliver_at);
+    link->last_deliver_at = msg->deliver_at;
+
+    link->queue[(link->head + link->count) % CONFIG_ZMK_SPLIT_LOOPBACK_QUEUE_SIZE] = *msg;
+    if (++link->count == 1) {
+        link_schedule(link, now);
+    }
+}
+
+static void link_work_callback(struct k_work *work) {
+    struct k_work_delayable *d_work = k_work_delayable_from_work(work);
+    struct loopback_link *link = CONTAINER_OF(d_work, struct loopback_link, work);
+    int64_t now = k_uptime_get();
+
+    while (link->count > 0 && link->queue[link->head].deliver_at <= now) {
+        link_deliver_head(link);
+    }
+
+    if (link->count > 0) {
+        link_schedule(link, now);
+    }
+}
+
+/*
+ * Keypress to HID report latency of keys on the simulated peripheral. A press waits here from
+ * its delivery until it produces a keycode press or its key is released. Keycode events carry
+ * the timestamp of the key press that caused them, which is how they are matched to a waiting
+ * press, so keycodes from the central's own keys aren't counted. A central key pressed in the
+ * same millisecond as a waiting peripheral key can't be told apart from it.
+ */
+static struct {
+    struct {
+        uint32_t position;
+        int64_t pressed_at;
+    } waiting[CONFIG_ZMK_SPLIT_LOOPBACK_QUEUE_SIZE];
+    size_t waiting_count;
+    uint32_t histogram[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+} latency;
+
+static void latency_press_delivered(uint32_t position, int64_t pressed_at) {
+    if (latency.waiting_count == ARRAY_SIZE(latency.waiting)) {
+        return;
+    }
+
+    latency.waiting[latency.waiting_count].position = position;
+    latency.waiting[latency.waiting_count].pressed_at = pressed_at;
+    latency.waiting_count++;
+}
+
+static void latency_release_delivered(uint32_t position) {
+    for (size_t i = 0; i < latency.waiting_count; i++) {
+        if (latency.waiting[i].position == position) {
+            memmove(&latency.waiting[i], &latency.waiting[i + 1],
+                    (latency.waiting_count - i - 1) * sizeof(latency.waiting[0]));
+            latency.waiting_count--;
+            return;
+        }
+    }
+}
+
+static uint32_t latency_percentile(uint32_t percent) {
+    uint32_t target = DIV_ROUND_UP(latency.count * percent, 100);
+    uint32_t seen = 0;
+
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += latency.histogram[i];
+        if (seen >= target) {
+            return i;
+        }
+    }
+
+    return LATENCY_BUCKETS - 1;
+}
+
+static void record_latency(uint32_t ms) {
+    latency.histogram[MIN(ms, LATENCY_BUCKETS - 1)]++;
+    latency.min = latency.count == 0 ? ms : MIN(latency.min, ms);
+    latency.max = MAX(latency.max, ms);
+    latency.count++;
+
+    LOG_DBG("%d ms, count %d, min %d, p50 %d, p90 %d, p99 %d, max %d", ms, latency.count,
+            latency.min, latency_percentile(50), latency_percentile(90), latency_percentile(99),
+            latency.max);
+}
+
+static int split_loopback_keycode_listener(const zmk_event_t *eh) {
+    const struct zmk_keycode_state_changed *ev = as_zmk_keycode_state_changed(eh);
+
+    if (ev == NULL || !ev->state) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    for (size_t i = latency.waiting_count; i-- > 0;) {
+        if (latency.waiting[i].pressed_at == ev->timestamp) {
+            record_latency(k_uptime_get() - ev->timestamp);
+            memmove(&latency.waiting[i], &latency.waiting[i + 1],
+                    (latency.waiting_count - i - 1) * sizeof(latency.waiting[0]));
+            latency.waiting_count--;
+            break;
+        }
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(split_loopback, split_loopback_keycode_listener);
+ZMK_SUBSCRIPTION(split_loopback, zmk_keycode_state_changed);
+
+static void deliver_to_central(const struct loopback_message *msg) {
+    LOG_DBG("Trigger key position state change for %d, state %d", msg->position.position,
+            msg->position.state);
+
+    if (msg->position.state) {
+        latency_press_delivered(msg->position.position, msg->position.timestamp);
+    }
+
+    raise_zmk_position_state_changed(msg->position);
+
+    // A press that hasn't produced a keycode by the time its key is released never will.
+    if (!msg->position.state) {
+        latency_release_delivered(msg->position.position);
+    }
+}
+
+static void deliver_to_peripheral(const struct loopback_message *msg) {
+    // The simulated peripheral shares its behavior devices with the central, which has already
+    // run global behaviors itself, so running them again would apply them twice.
+    LOG_DBG("%s with params %d %d: pressed? %d", msg->behavior.binding.behavior_dev,
+            msg->behavior.binding.param1, msg->behavior.binding.param2, msg->behavior.state);
+}
+
+static struct loopback_link to_central = {.name = "central", .deliver = deliver_to_central};
+static struct loopback_link to_peripheral = {.name = "peripheral",
+                                             .deliver = deliver_to_peripheral};
+
+static void peripheral_kscan_callback(const struct device *dev, uint32_t row, uint32_t column,
+                                      bool pressed) {
+    int32_t position = zmk_matrix_transform_row_column_to_position(
+        row + DT_INST_PROP(0, row_offset), column + DT_INST_PROP(0, column_offset));
+
+    if (position < 0 || position >= ZMK_KEYMAP_LEN) {
+        LOG_WRN("Not found in transform: row: %d, col: %d, pressed: %s", row, column,
+                (pressed ? "true" : "false"));
+        return;
+    }
+
+    struct loopback_message msg = {
+        .type = LOOPBACK_MSG_POSITION,
+        .position = {.source = PERIPHERAL_SOURCE,
+                     .position = position,
+                     .state = pressed,
+                     .timestamp = k_uptime_get()},
+    };
+    link_send(&to_central, &msg);
+}
+
+int zmk_split_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
+                              struct zmk_behavior_binding_event event, bool state) {
+    struct loopback_message msg = {
+        .type = LOOPBACK_MSG_INVOKE_BEHAVIOR,
+        .behavior = {.binding = *binding, .event = event, .state = state},
+    };
+
+    link_send(&to_peripheral, &msg);
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+int zmk_split_update_hid_indicator(zmk_hid_indicators_t indicators) {
+    // The central has already raised the indicators changed event the peripheral would.
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+static int split_loopback_init(void) {
+    const struct device *kscan = DEVICE_DT_GET(DT_INST_PHANDLE(0, kscan));
+
+    if (!device_is_ready(kscan)) {
+        LOG_ERR("Simulated peripheral KSCAN device is not ready");
+        return -ENODEV;
+    }
+
+    k_work_init_delayable(&to_central.work, link_work_callback);
+    k_work_init_delayable(&to_peripheral.work, link_work_callback);
+
+    kscan_config(kscan, peripheral_kscan_callback);
+    kscan_enable_callback(kscan);
+
+    return 0;
+}
+
+SYS_INIT(split_loopback_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
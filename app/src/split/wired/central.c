@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/behavior.h>
+#include <zmk/sensors.h>
+#include <zmk/split/central.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/events/sensor_event.h>
+
+#include "wired.h"
+
+// A wired central has exactly one peripheral.
+#define PERIPHERAL_SOURCE 0
+
+// Only touched from the work queue packets are handled on.
+static uint8_t position_state[ZMK_SPLIT_WIRED_POS_STATE_LEN];
+static uint8_t next_sequence;
+static bool sequence_known;
+
+static bool position_is_pressed(const uint8_t *state, uint32_t position) {
+    return (state[position / 8] & BIT(position % 8)) != 0;
+}
+
+static void set_position_state(uint32_t position, bool pressed, int64_t timestamp) {
+    if (position >= ZMK_KEYMAP_LEN) {
+        LOG_WRN("Ignoring position %d beyond the keymap", position);
+        return;
+    }
+
+    if (position_is_pressed(position_state, position) == pressed) {
+        return;
+    }
+
+    WRITE_BIT(position_state[position / 8], position % 8, pressed);
+
+    raise_zmk_position_state_changed((struct zmk_position_state_changed){
+        .source = PERIPHERAL_SOURCE,
+        .position = position,
+        .state = pressed,
+        .timestamp = timestamp,
+    });
+}
+
+// Releases every position of the peripheral once nothing has been received from it for the link
+// timeout. The peripheral keeps sending while keys are held, so only a lost link gets here.
+static void link_timeout_work_callback(struct k_work *work) {
+    int64_t now = k_uptime_get();
+
+    for (uint32_t position = 0; position < ZMK_KEYMAP_LEN; position++) {
+        if (position_is_pressed(position_state, position)) {
+            LOG_WRN("Lost the link to the peripheral, releasing key position %d", position);
+            set_position_state(position, false, now);
+        }
+    }
+
+    // Whatever the peripheral sends next, it can't be checked against the events lost meanwhile.
+    sequence_known = false;
+}
+
+static K_WORK_DELAYABLE_DEFINE(link_timeout_work, link_timeout_work_callback);
+
+static void handle_position_event(const uint8_t *payload, uint8_t length) {
+    struct zmk_split_wired_position_event ev;
+
+    if (length != sizeof(ev)) {
+        LOG_WRN("Ignoring position event with unexpected length %d", length);
+        return;
+    }
+
+    memcpy(&ev, payload, sizeof(ev));
+
+    if (sequence_known && ev.sequence != next_sequence) {
+        LOG_WRN("Lost %d position events, requesting the position state",
+                (uint8_t)(ev.sequence - next_sequence));
+        zmk_split_wired_send(ZMK_SPLIT_WIRED_MSG_REQUEST_POSITION_STATE, NULL, 0);
+    }
+
+    next_sequence = ev.sequence + 1;
+    sequence_known = true;
+
+    uint32_t position = sys_le16_to_cpu(ev.position);
+    LOG_DBG("Trigger key position state change for %d, state %d", position, ev.pressed);
+
+    set_position_state(position, ev.pressed > 0, k_uptime_get() - sys_le16_to_cpu(ev.age));
+}
+
+static void handle_position_state(const uint8_t *payload, uint8_t length) {
+    struct zmk_split_wired_position_state msg;
+
+    if (length != sizeof(msg)) {
+        LOG_WRN("Ignoring position state with unexpected length %d", length);
+        return;
+    }
+
+    memcpy(&msg, payload, sizeof(msg));
+
+    next_sequence = msg.sequence;
+    sequence_known = true;
+
+    int64_t now = k_uptime_get();
+
+    for (uint32_t position = 0; position < ZMK_KEYMAP_LEN; position++) {
+        bool pressed = position_is_pressed(msg.state, position);
+
+        if (pressed != position_is_pressed(position_state, position)) {
+            LOG_WRN("Resyncing key position %d, state %d", position, pressed);
+            set_position_state(position, pressed, now);
+        }
+    }
+}
+
+#if ZMK_KEYMAP_HAS_SENSORS
+static void handle_sensor_event(const uint8_t *payload, uint8_t length) {
+    struct zmk_split_wired_sensor_event sensor_event = {0};
+
+    if (length < offsetof(struct zmk_split_wired_sensor_event, channel_data)) {
+        LOG_WRN("Ignoring sensor event with insufficient data length (%d)", length);
+        return;
+    }
+
+    memcpy(&sensor_event, payload, MIN(length, sizeof(sensor_event)));
+    struct zmk_sensor_event ev = {
+        .sensor_index = sensor_event.sensor_index,
+        .channel_data_size = MIN(sensor_event.channel_data_size, ZMK_SENSOR_EVENT_MAX_CHANNELS),
+        .timestamp = k_uptime_get()};
+
+    memcpy(ev.channel_data, sensor_event.channel_data,
+           sizeof(struct zmk_sensor_channel_data) * ev.channel_data_size);
+
+    LOG_DBG("Trigger sensor change for %d", ev.sensor_index);
+    raise_zmk_sensor_event(ev);
+}
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+void zmk_split_wired_handle_message(uint8_t type, const uint8_t *payload, uint8_t length) {
+    k_work_reschedule(&link_timeout_work, K_MSEC(CONFIG_ZMK_SPLIT_WIRED_LINK_TIMEOUT_MS));
+
+    switch (type) {
+    case ZMK_SPLIT_WIRED_MSG_POSITION_EVENT:
+        handle_position_event(payload, length);
+        break;
+    case ZMK_SPLIT_WIRED_MSG_POSITION_STATE:
+        handle_position_state(payload, length);
+        break;
+#if ZMK_KEYMAP_HAS_SENSORS
+    case ZMK_SPLIT_WIRED_MSG_SENSOR_EVENT:
+        handle_sensor_event(payload, length);
+        break;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+    default:
+        LOG_WRN("Ignoring unexpected packet type 0x%02x", type);
+        break;
+    }
+}
+
+int zmk_split_invoke_behavior(uint8_t source, struct zmk_behavior_binding *binding,
+                              struct zmk_behavior_binding_event event, bool state) {
+    uint8_t buf[ZMK_SPLIT_WIRED_PAYLOAD_MAX];
+    struct zmk_split_wired_invoke_behavior *msg = (void *)buf;
+    const size_t name_size = strlen(binding->behavior_dev) + 1;
+
+    if (source != PERIPHERAL_SOURCE) {
+        return -EINVAL;
+    }
+
+    if (sizeof(*msg) + name_size > sizeof(buf)) {
+        LOG_ERR("Behavior label %s is too long to invoke on the peripheral", binding->behavior_dev);
+        return -EINVAL;
+    }
+
+    msg->position = sys_cpu_to_le16(event.position);
+    msg->state = state ? 1 : 0;
+    msg->param1 = sys_cpu_to_le32(binding->param1);
+    msg->param2 = sys_cpu_to_le32(binding->param2);
+    memcpy(msg->behavior_dev, binding->behavior_dev, name_size);
+
+    return zmk_split_wired_send(ZMK_SPLIT_WIRED_MSG_INVOKE_BEHAVIOR, buf, sizeof(*msg) + name_size);
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+int zmk_split_update_hid_indicator(zmk_hid_indicators_t indicators) {
+    return zmk_split_wired_send(ZMK_SPLIT_WIRED_MSG_HID_INDICATORS, &indicators,
+                                sizeof(indicators));
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <drivers/behavior.h>
+#include <zmk/behavior.h>
+#include <zmk/split/peripheral.h>
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#include <zmk/events/hid_indicators_changed.h>
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+#include "wired.h"
+
+// Guards the position state and sequence, so the state sent to the central always matches the
+// sequence number sent with it.
+K_MUTEX_DEFINE(position_state_mutex);
+
+static struct zmk_split_wired_position_state position_state;
+
+static void send_position_state(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(position_state_work, send_position_state);
+
+static bool any_position_pressed(void) {
+    for (size_t i = 0; i < ARRAY_SIZE(position_state.state); i++) {
+        if (position_state.state[i] != 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void send_position_state(struct k_work *work) {
+    k_mutex_lock(&position_state_mutex, K_FOREVER);
+    zmk_split_wired_send(ZMK_SPLIT_WIRED_MSG_POSITION_STATE, &position_state,
+                         sizeof(position_state));
+    bool pressed = any_position_pressed();
+    k_mutex_unlock(&position_state_mutex);
+
+    // Keep the central from timing out the link while keys are held.
+    if (pressed) {
+        k_work_reschedule(&position_state_work, K_MSEC(CONFIG_ZMK_SPLIT_WIRED_KEEPALIVE_MS));
+    }
+}
+
+static int send_position_event(uint32_t position, bool pressed, int64_t timestamp) {
+    if (position >= ZMK_KEYMAP_LEN) {
+        return -EINVAL;
+    }
+
+    int64_t age = CLAMP(k_uptime_get() - timestamp, 0, UINT16_MAX);
+    struct zmk_split_wired_position_event ev = {
+        .position = sys_cpu_to_le16(position),
+        .pressed = pressed ? 1 : 0,
+        .age = sys_cpu_to_le16(age),
+    };
+
+    k_mutex_lock(&position_state_mutex, K_FOREVER);
+
+    WRITE_BIT(position_state.state[position / 8], position % 8, pressed);
+    ev.sequence = position_state.sequence++;
+
+    int err = zmk_split_wired_send(ZMK_SPLIT_WIRED_MSG_POSITION_EVENT, &ev, sizeof(ev));
+
+    k_mutex_unlock(&position_state_mutex);
+
+    k_work_reschedule(&position_state_work, K_MSEC(CONFIG_ZMK_SPLIT_WIRED_POSITION_STATE_DELAY_MS));
+
+    return err;
+}
+
+int zmk_split_position_pressed(uint32_t position, int64_t timestamp) {
+    return send_position_event(position, true, timestamp);
+}
+
+int zmk_split_position_released(uint32_t position, int64_t timestamp) {
+    return send_position_event(position, false, timestamp);
+}
+
+#if ZMK_KEYMAP_HAS_SENSORS
+int zmk_split_sensor_triggered(uint8_t sensor_index,
+                               const struct zmk_sensor_channel_data channel_data[],
+                               size_t channel_data_size) {
+    if (channel_data_size > ZMK_SENSOR_EVENT_MAX_CHANNELS) {
+        return -EINVAL;
+    }
+
+    struct zmk_split_wired_sensor_event ev = {.sensor_index = sensor_index,
+                                              .channel_data_size = channel_data_size};
+    memcpy(ev.channel_data, channel_data,
+           channel_data_size * sizeof(struct zmk_sensor_channel_data));
+
+    return zmk_split_wired_send(ZMK_SPLIT_WIRED_MSG_SENSOR_EVENT, &ev,
+                                offsetof(struct zmk_split_wired_sensor_event, channel_data) +
+                                    channel_data_size * sizeof(struct zmk_sensor_channel_data));
+}
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+static void handle_invoke_behavior(const uint8_t *payload, uint8_t length) {
+    const struct zmk_split_wired_invoke_behavior *msg = (const void *)payload;
+
+    if (length <= sizeof(*msg) || payload[length - 1] != '\0') {
+        LOG_WRN("Ignoring malformed behavior invocation (length %d)", length);
+        return;
+    }
+
+    struct zmk_behavior_binding binding = {
+        .param1 = sys_le32_to_cpu(msg->param1),
+        .param2 = sys_le32_to_cpu(msg->param2),
+        .behavior_dev = (char *)msg->behavior_dev,
+    };
+    LOG_DBG("%s with params %d %d: pressed? %d", binding.behavior_dev, binding.param1,
+            binding.param2, msg->state);
+    struct zmk_behavior_binding_event event = {.position = sys_le16_to_cpu(msg->position),
+                                               .timestamp = k_uptime_get()};
+    int err;
+    if (msg->state > 0) {
+        err = behavior_keymap_binding_pressed(&binding, event);
+    } else {
+        err = behavior_keymap_binding_released(&binding, event);
+    }
+
+    if (err) {
+        LOG_ERR("Failed to invoke behavior %s: %d", binding.behavior_dev, err);
+    }
+}
+
+void zmk_split_wired_handle_message(uint8_t type, const uint8_t *payload, uint8_t length) {
+    switch (type) {
+    case ZMK_SPLIT_WIRED_MSG_INVOKE_BEHAVIOR:
+        handle_invoke_behavior(payload, length);
+        break;
+    case ZMK_SPLIT_WIRED_MSG_REQUEST_POSITION_STATE:
+        LOG_DBG("Central requested the position state");
+        k_work_reschedule(&position_state_work, K_NO_WAIT);
+        break;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    case ZMK_SPLIT_WIRED_MSG_HID_INDICATORS:
+        if (length != sizeof(zmk_hid_indicators_t)) {
+            LOG_WRN("Ignoring HID indicators with unexpected length %d", length);
+            break;
+        }
+
+        LOG_DBG("Raising HID indicators changed event: %x", payload[0]);
+        raise_zmk_hid_indicators_changed(
+            (struct zmk_hid_indicators_changed){.indicators = payload[0]});
+        break;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    default:
+        LOG_WRN("Ignoring unexpected packet type 0x%02x", type);
+        break;
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_split_wired_peripheral_mock
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/matrix.h>
+#include <zmk/matrix_transform.h>
+
+#include "wired.h"
+
+BUILD_ASSERT(DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT) == 1,
+             "Exactly one zmk,split-wired-peripheral-mock node must be enabled");
+BUILD_ASSERT(DT_NODE_HAS_COMPAT(DT_CHOSEN(zmk_split_uart), zephyr_uart_emul),
+             "The wired peripheral mock needs an emulated zmk,split-uart");
+
+/*
+ * Stands in for a wired peripheral in a central image, writing the packets a real peripheral
+ * would send into the receive side of the emulated split UART. The position events listed in
+ * drop-events are left out, as if they had been lost on the wire, and nothing at all is sent after
+ * the event at link-lost-after, to test how the central recovers. Packets sent by the central are
+ * ignored.
+ *
+ * Everything here runs on the system work queue, which is where kscan_mock calls back from.
+ */
+
+static const struct device *uart = DEVICE_DT_GET(DT_CHOSEN(zmk_split_uart));
+static const uint32_t drop_events[] = DT_INST_PROP_OR(0, drop_events, {});
+
+static struct zmk_split_wired_position_state position_state;
+static uint32_t event_index;
+static bool link_lost;
+
+static void put_packet(uint8_t type, const void *payload, uint8_t length) {
+    uint8_t buf[ZMK_SPLIT_WIRED_PACKET_MAX];
+
+    if (link_lost) {
+        return;
+    }
+
+    uart_emul_put_rx_data(uart, buf, zmk_split_wired_frame(buf, type, payload, length));
+}
+
+static void send_position_state(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(position_state_work, send_position_state);
+
+static void send_position_state(struct k_work *work) {
+    put_packet(ZMK_SPLIT_WIRED_MSG_POSITION_STATE, &position_state, sizeof(position_state));
+
+    // Keep the link alive while keys are held, as a real peripheral does.
+    for (size_t i = 0; i < ARRAY_SIZE(position_state.state); i++) {
+        if (position_state.state[i] != 0) {
+            k_work_reschedule(&position_state_work, K_MSEC(CONFIG_ZMK_SPLIT_WIRED_KEEPALIVE_MS));
+            break;
+        }
+    }
+}
+
+static bool is_dropped(uint32_t index) {
+    for (size_t i = 0; i < ARRAY_SIZE(drop_events); i++) {
+        if (drop_events[i] == index) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void peripheral_kscan_callback(const struct device *dev, uint32_t row, uint32_t column,
+                                      bool pressed) {
+    int32_t position = zmk_matrix_transform_row_column_to_position(
+        row + DT_INST_PROP(0, row_offset), column + DT_INST_PROP(0, column_offset));
+
+    if (position < 0 || position >= ZMK_KEYMAP_LEN) {
+        LOG_WRN("Not found in transform: row: %d, col: %d, pressed: %s", row, column,
+                (pressed ? "true" : "false"));
+        return;
+    }
+
+    struct zmk_split_wired_position_event ev = {
+        .sequence = position_state.sequence++,
+        .position = sys_cpu_to_le16(position),
+        .pressed = pressed ? 1 : 0,
+    };
+
+    WRITE_BIT(position_state.state[position / 8], position % 8, pressed);
+
+    if (is_dropped(event_index)) {
+        LOG_DBG("Dropping position event for %d, state %d", position, pressed);
+    } else {
+        put_packet(ZMK_SPLIT_WIRED_MSG_POSITION_EVENT, &ev, sizeof(ev));
+    }
+
+#if DT_INST_NODE_HAS_PROP(0, link_lost_after)
+    if (event_index == DT_INST_PROP(0, link_lost_after)) {
+        LOG_DBG("Breaking the link after position event for %d, state %d", position, pressed);
+        link_lost = true;
+    }
+#endif
+
+    event_index++;
+
+    k_work_reschedule(&position_state_work, K_MSEC(CONFIG_ZMK_SPLIT_WIRED_POSITION_STATE_DELAY_MS));
+}
+
+static int split_wired_peripheral_mock_init(void) {
+    const struct device *kscan = DEVICE_DT_GET(DT_INST_PHANDLE(0, kscan));
+
+    if (!device_is_ready(kscan)) {
+        LOG_ERR("Mock peripheral KSCAN device is not ready");
+        return -ENODEV;
+    }
+
+    kscan_config(kscan, peripheral_kscan_callback);
+    kscan_enable_callback(kscan);
+
+    return 0;
+}
+
+SYS_INIT(split_wired_peripheral_mock_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include "wired.h"
+
+static const struct device *uart = DEVICE_DT_GET(DT_CHOSEN(zmk_split_uart));
+
+enum rx_state {
+    RX_STATE_SYNC_0,
+    RX_STATE_SYNC_1,
+    RX_STATE_TYPE,
+    RX_STATE_LENGTH,
+    RX_STATE_PAYLOAD,
+    RX_STATE_CRC_0,
+    RX_STATE_CRC_1,
+};
+
+// Only touched from the system work queue.
+static struct {
+    enum rx_state state;
+    uint8_t type;
+    uint8_t length;
+    uint8_t received;
+    uint16_t crc;
+    uint8_t payload[ZMK_SPLIT_WIRED_PAYLOAD_MAX];
+} rx;
+
+static uint16_t packet_crc(uint8_t type, uint8_t length, const uint8_t *payload) {
+    const uint8_t header[] = {type, length};
+    uint16_t crc = crc16_ccitt(0xFFFF, header, sizeof(header));
+
+    return crc16_ccitt(crc, payload, length);
+}
+
+static void rx_process_byte(uint8_t byte) {
+    switch (rx.state) {
+    case RX_STATE_SYNC_0:
+        if (byte == ZMK_SPLIT_WIRED_SYNC_0) {
+            rx.state = RX_STATE_SYNC_1;
+        }
+        break;
+    case RX_STATE_SYNC_1:
+        if (byte == ZMK_SPLIT_WIRED_SYNC_1) {
+            rx.state = RX_STATE_TYPE;
+        } else if (byte != ZMK_SPLIT_WIRED_SYNC_0) {
+            rx.state = RX_STATE_SYNC_0;
+        }
+        break;
+    case RX_STATE_TYPE:
+        rx.type = byte;
+        rx.state = RX_STATE_LENGTH;
+        break;
+    case RX_STATE_LENGTH:
+        if (byte > ZMK_SPLIT_WIRED_PAYLOAD_MAX) {
+            LOG_WRN("Dropping packet with oversized payload (%d)", byte);
+            rx.state = RX_STATE_SYNC_0;
+            break;
+        }
+
+        rx.length = byte;
+        rx.received = 0;
+        rx.state = rx.length > 0 ? RX_STATE_PAYLOAD : RX_STATE_CRC_0;
+        break;
+    case RX_STATE_PAYLOAD:
+        rx.payload[rx.received++] = byte;
+        if (rx.received == rx.length) {
+            rx.state = RX_STATE_CRC_0;
+        }
+        break;
+    case RX_STATE_CRC_0:
+        rx.crc = byte;
+        rx.state = RX_STATE_CRC_1;
+        break;
+    case RX_STATE_CRC_1:
+        rx.crc |= (uint16_t)byte << 8;
+        rx.state = RX_STATE_SYNC_0;
+
+        if (rx.crc != packet_crc(rx.type, rx.length, rx.payload)) {
+            LOG_WRN("Dropping packet of type 0x%02x with bad CRC", rx.type);
+            break;
+        }
+
+        zmk_split_wired_handle_message(rx.type, rx.payload, rx.length);
+        break;
+    }
+}
+
+K_MUTEX_DEFINE(tx_mutex);
+
+// Guarded by tx_mutex. Must outlive an asynchronous transfer, so it can't live on the stack.
+static uint8_t tx_buf[ZMK_SPLIT_WIRED_PACKET_MAX];
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_MODE_ASYNC)
+
+RING_BUF_DECLARE(rx_ring_buf, CONFIG_ZMK_SPLIT_WIRED_RX_BUFFER_SIZE);
+
+static uint8_t async_rx_bufs[2][ZMK_SPLIT_WIRED_PAYLOAD_MAX];
+static uint8_t async_rx_buf_next;
+
+K_SEM_DEFINE(tx_done_sem, 0, 1);
+
+static void rx_work_callback(struct k_work *work) {
+    uint8_t *data;
+    uint32_t len;
+
+    while ((len = ring_buf_get_claim(&rx_ring_buf, &data, CONFIG_ZMK_SPLIT_WIRED_RX_BUFFER_SIZE)) >
+           0) {
+        for (uint32_t i = 0; i < len; i++) {
+            rx_process_byte(data[i]);
+        }
+        ring_buf_get_finish(&rx_ring_buf, len);
+    }
+}
+
+K_WORK_DEFINE(rx_work, rx_work_callback);
+
+static int async_rx_enable(void) {
+    async_rx_buf_next = 1;
+
+    return uart_rx_enable(uart, async_rx_bufs[0], sizeof(async_rx_bufs[0]),
+                          CONFIG_ZMK_SPLIT_WIRED_ASYNC_RX_TIMEOUT);
+}
+
+static void uart_callback(const struct device *dev, struct uart_event *evt, void *user_data) {
+    switch (evt->type) {
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        k_sem_give(&tx_done_sem);
+        break;
+    case UART_RX_RDY: {
+        uint32_t put =
+            ring_buf_put(&rx_ring_buf, evt->data.rx.buf + evt->data.rx.offset, evt->data.rx.len);
+        if (put < evt->data.rx.len) {
+            LOG_WRN("Receive buffer full, dropped %d bytes", evt->data.rx.len - put);
+        }
+        k_work_submit(&rx_work);
+        break;
+    }
+    case UART_RX_BUF_REQUEST:
+        uart_rx_buf_rsp(dev, async_rx_bufs[async_rx_buf_next], sizeof(async_rx_bufs[0]));
+        async_rx_buf_next ^= 1;
+        break;
+    case UART_RX_STOPPED:
+        LOG_WRN("Receiving stopped (reason %d)", evt->data.rx_stop.reason);
+        break;
+    case UART_RX_DISABLED: {
+        int err = async_rx_enable();
+        if (err) {
+            LOG_ERR("Failed to re-enable receiving (err %d)", err);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static int transmit(size_t len) {
+    k_sem_reset(&tx_done_sem);
+
+    int err = uart_tx(uart, tx_buf, len, SYS_FOREVER_US);
+    if (err) {
+        return err;
+    }
+
+    if (k_sem_take(&tx_done_sem, K_MSEC(CONFIG_ZMK_SPLIT_WIRED_TX_TIMEOUT)) != 0) {
+        uart_tx_abort(uart);
+        return -ETIMEDOUT;
+    }
+
+    return 0;
+}
+
+#else
+
+static void polling_rx_work_callback(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(polling_rx_work, polling_rx_work_callback);
+
+static void polling_rx_work_callback(struct k_work *work) {
+    uint8_t byte;
+
+    while (uart_poll_in(uart, &byte) == 0) {
+        rx_process_byte(byte);
+    }
+
+    k_work_schedule(&polling_rx_work, K_MSEC(CONFIG_ZMK_SPLIT_WIRED_POLLING_RX_PERIOD));
+}
+
+static int transmit(size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uart_poll_out(uart, tx_buf[i]);
+    }
+
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_MODE_ASYNC)
+
+size_t zmk_split_wired_frame(uint8_t *buf, uint8_t type, const void *payload, uint8_t length) {
+    __ASSERT_NO_MSG(length <= ZMK_SPLIT_WIRED_PAYLOAD_MAX);
+
+    buf[0] = ZMK_SPLIT_WIRED_SYNC_0;
+    buf[1] = ZMK_SPLIT_WIRED_SYNC_1;
+    buf[2] = type;
+    buf[3] = length;
+    memcpy(&buf[ZMK_SPLIT_WIRED_HEADER_SIZE], payload, length);
+
+    uint16_t crc = packet_crc(type, length, &buf[ZMK_SPLIT_WIRED_HEADER_SIZE]);
+    buf[ZMK_SPLIT_WIRED_HEADER_SIZE + length] = crc & 0xFF;
+    buf[ZMK_SPLIT_WIRED_HEADER_SIZE + length + 1] = crc >> 8;
+
+    return ZMK_SPLIT_WIRED_HEADER_SIZE + length + ZMK_SPLIT_WIRED_CRC_SIZE;
+}
+
+int zmk_split_wired_send(uint8_t type, const void *payload, uint8_t length) {
+    if (length > ZMK_SPLIT_WIRED_PAYLOAD_MAX) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&tx_mutex, K_FOREVER);
+
+    int err = transmit(zmk_split_wired_frame(tx_buf, type, payload, length));
+
+    k_mutex_unlock(&tx_mutex);
+
+    if (err) {
+        LOG_ERR("Failed to send packet of type 0x%02x (err %d)", type, err);
+    }
+
+    return err;
+}
+
+static int zmk_split_wired_init(void) {
+    if (!device_is_ready(uart)) {
+        LOG_ERR("Split UART %s is not ready", uart->name);
+        return -ENODEV;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_MODE_ASYNC)
+    int err = uart_callback_set(uart, uart_callback, NULL);
+    if (err) {
+        LOG_ERR("Failed to set the split UART callback (err %d)", err);
+        return err;
+    }
+
+    err = async_rx_enable();
+    if (err) {
+        LOG_ERR("Failed to enable receiving on the split UART (err %d)", err);
+        return err;
+    }
+#else
+    k_work_schedule(&polling_rx_work, K_NO_WAIT);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_WIRED_UART_MODE_ASYNC)
+
+    return 0;
+}
+
+SYS_INIT(zmk_split_wired_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
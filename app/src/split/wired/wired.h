@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/sys/util.h>
+#include <zephyr/types.h>
+
+#include <zmk/matrix.h>
+#include <zmk/sensors.h>
+#include <zmk/events/sensor_event.h>
+
+/*
+ * Every packet on the wire is framed as:
+ *
+ *   sync (2 bytes) | type | payload length | payload | CRC-16/CCITT (little endian)
+ *
+ * The CRC covers the type, length and payload. Receivers hunt for the sync bytes again after any
+ * malformed packet, so a corrupted or partial packet only costs the packet itself.
+ *
+ * Position events carry a sequence number. Since a lost packet is never resent, the peripheral
+ * also sends its full position state once keys have been idle for a moment, and whenever the
+ * central notices a gap in the sequence and asks for it. The central then raises events for any
+ * position whose state it got wrong, so a lost release can't leave a key stuck.
+ *
+ * While keys are held, the peripheral keeps resending its position state, and the central releases
+ * every key of the peripheral if the link goes quiet for too long, as if it had disconnected.
+ */
+#define ZMK_SPLIT_WIRED_SYNC_0 0x5A
+#define ZMK_SPLIT_WIRED_SYNC_1 0xA5
+
+#define ZMK_SPLIT_WIRED_HEADER_SIZE 4
+#define ZMK_SPLIT_WIRED_CRC_SIZE 2
+#define ZMK_SPLIT_WIRED_PAYLOAD_MAX 48
+#define ZMK_SPLIT_WIRED_PACKET_MAX                                                                 \
+    (ZMK_SPLIT_WIRED_HEADER_SIZE + ZMK_SPLIT_WIRED_PAYLOAD_MAX + ZMK_SPLIT_WIRED_CRC_SIZE)
+
+// Size of the position state bitmap, one bit per key position.
+#define ZMK_SPLIT_WIRED_POS_STATE_LEN DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8)
+
+enum zmk_split_wired_message_type {
+    // Peripheral to central.
+    ZMK_SPLIT_WIRED_MSG_POSITION_EVENT = 0x01,
+    ZMK_SPLIT_WIRED_MSG_SENSOR_EVENT = 0x02,
+    ZMK_SPLIT_WIRED_MSG_POSITION_STATE = 0x03,
+
+    // Central to peripheral.
+    ZMK_SPLIT_WIRED_MSG_INVOKE_BEHAVIOR = 0x81,
+    ZMK_SPLIT_WIRED_MSG_HID_INDICATORS = 0x82,
+    // No payload.
+    ZMK_SPLIT_WIRED_MSG_REQUEST_POSITION_STATE = 0x83,
+};
+
+struct zmk_split_wired_position_event {
+    // Incremented for every position event the peripheral sends.
+    uint8_t sequence;
+    // Little endian.
+    uint16_t position;
+    uint8_t pressed;
+    // Little endian. Milliseconds between the key being scanned and the packet being sent.
+    uint16_t age;
+} __packed;
+
+struct zmk_split_wired_position_state {
+    // Sequence number of the next position event the peripheral will send.
+    uint8_t sequence;
+    uint8_t state[ZMK_SPLIT_WIRED_POS_STATE_LEN];
+} __packed;
+
+BUILD_ASSERT(sizeof(struct zmk_split_wired_position_state) <= ZMK_SPLIT_WIRED_PAYLOAD_MAX,
+             "Too many key positions for the wired split position state");
+
+struct zmk_split_wired_sensor_event {
+    uint8_t sensor_index;
+    uint8_t channel_data_size;
+    struct zmk_sensor_channel_data channel_data[ZMK_SENSOR_EVENT_MAX_CHANNELS];
+} __packed;
+
+struct zmk_split_wired_invoke_behavior {
+    // All fields are little endian.
+    uint16_t position;
+    uint8_t state;
+    uint32_t param1;
+    uint32_t param2;
+    // NUL terminated name of the behavior device, filling the rest of the payload.
+    char behavior_dev[];
+} __packed;
+
+/**
+ * @brief Frame one packet into @p buf, which must hold ZMK_SPLIT_WIRED_PACKET_MAX bytes.
+ *
+ * @retval The number of bytes written to @p buf.
+ */
+size_t zmk_split_wired_frame(uint8_t *buf, uint8_t type, const void *payload, uint8_t length);
+
+/**
+ * @brief Frame and send one packet to the other half.
+ *
+ * Blocks until the packet is handed to the UART, so must not be called from an ISR.
+ */
+int zmk_split_wired_send(uint8_t type, const void *payload, uint8_t length);
+
+/**
+ * @brief Handle a packet received from the other half.
+ *
+ * Implemented by the central and peripheral side of the transport and called from the system
+ * work queue for every packet that passed its CRC check.
+ */
+void zmk_split_wired_handle_message(uint8_t type, const uint8_t *payload, uint8_t length);
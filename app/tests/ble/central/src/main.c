@@ -44,7 +44,10 @@ static bool read_hid_report_on_connect = false;
 static bool skip_set_security_on_connect = false;
 static bool skip_discovery_on_connect = false;
 static bool read_directly_on_discovery = false;
+static bool log_conn_param_updates = false;
+static bool subscribe_all_reports = false;
 static int32_t wait_on_start = 0;
+static uint32_t disconnect_after_notifications = 0;
 
 static void ble_central_native_posix_options(void) {
     static struct args_struct_t options[] = {
@@ -83,6 +86,22 @@ static void ble_central_native_posix_options(void) {
          .type = 'b',
          .dest = (void *)&read_directly_on_discovery,
          .descript = "Read HIDS report after GATT characteristic discovery"},
+        {.is_switch = true,
+         .option = "log_conn_param_updates",
+         .type = 'b',
+         .dest = (void *)&log_conn_param_updates,
+         .descript = "Log connection parameter updates requested by the peripheral"},
+        {.is_switch = true,
+         .option = "subscribe_all_reports",
+         .type = 'b',
+         .dest = (void *)&subscribe_all_reports,
+         .descript = "Subscribe to every HIDS input report, not just the first one"},
+        {.option = "disconnect_after_notifications",
+         .name = "count",
+         .type = 'u',
+         .dest = (void *)&disconnect_after_notifications,
+         .descript = "Disconnect and reconnect once this many notifications have been received, "
+                     "while more may still be in flight"},
         {.option = "wait_on_start",
          .name = "milliseconds",
          .type = 'u',
@@ -103,7 +122,11 @@ static struct bt_conn *default_conn;
 
 static struct bt_uuid_16 uuid = BT_UUID_INIT_16(0);
 static struct bt_gatt_discover_params discover_params;
-static struct bt_gatt_subscribe_params subscribe_params;
+// Keyboard, consumer and mouse input reports.
+#define MAX_SUBSCRIPTIONS 3
+
+static struct bt_gatt_subscribe_params subscribe_params[MAX_SUBSCRIPTIONS];
+static size_t subscribe_index;
 
 static uint8_t notify_func(struct bt_conn *conn, struct bt_gatt_subscribe_params *params,
                            const void *data, uint16_t length) {
@@ -115,6 +138,11 @@ static uint8_t notify_func(struct bt_conn *conn, struct bt_gatt_subscribe_params
 
     LOG_HEXDUMP_DBG(data, length, "payload");
 
+    if (disconnect_after_notifications > 0 && --disconnect_after_notifications == 0) {
+        LOG_DBG("[Disconnecting with notifications in flight]");
+        bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    }
+
     return BT_GATT_ITER_CONTINUE;
 }
 
@@ -151,6 +179,14 @@ static uint8_t discover_func(struct bt_conn *conn, const struct bt_gatt_attr *at
             LOG_DBG("[Discover failed] (err %d)", err);
         }
     } else if (!bt_uuid_cmp(discover_params.uuid, BT_UUID_HIDS_REPORT)) {
+        const struct bt_gatt_chrc *chrc = attr->user_data;
+
+        if (subscribe_all_reports && !(chrc->properties & BT_GATT_CHRC_NOTIFY)) {
+            // Input reports come first, so there is nothing left to subscribe to.
+            LOG_DBG("[Discover complete]");
+            return BT_GATT_ITER_STOP;
+        }
+
         if (read_directly_on_discovery) {
             read_params.single.handle = bt_gatt_attr_value_handle(attr);
             read_params.single.offset = 0;
@@ -163,7 +199,7 @@ static uint8_t discover_func(struct bt_conn *conn, const struct bt_gatt_attr *at
             discover_params.uuid = &uuid.uuid;
             discover_params.start_handle = attr->handle + 2;
             discover_params.type = BT_GATT_DISCOVER_DESCRIPTOR;
-            subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
+            subscribe_params[subscribe_index].value_handle = bt_gatt_attr_value_handle(attr);
 
             err = bt_gatt_discover(conn, &discover_params);
             if (err) {
@@ -171,17 +207,31 @@ static uint8_t discover_func(struct bt_conn *conn, const struct bt_gatt_attr *at
             }
         }
     } else {
-        subscribe_params.notify = notify_func;
-        subscribe_params.value = BT_GATT_CCC_NOTIFY;
-        subscribe_params.ccc_handle = attr->handle;
+        struct bt_gatt_subscribe_params *sub = &subscribe_params[subscribe_index];
+
+        sub->notify = notify_func;
+        sub->value = BT_GATT_CCC_NOTIFY;
+        sub->ccc_handle = attr->handle;
 
-        err = bt_gatt_subscribe(conn, &subscribe_params);
+        err = bt_gatt_subscribe(conn, sub);
         if (err && err != -EALREADY) {
             LOG_DBG("[Subscribe failed] (err %d)", err);
         } else {
             LOG_DBG("[SUBSCRIBED]");
         }
 
+        if (subscribe_all_reports && ++subscribe_index < MAX_SUBSCRIPTIONS) {
+            memcpy(&uuid, BT_UUID_HIDS_REPORT, sizeof(uuid));
+            discover_params.uuid = &uuid.uuid;
+            discover_params.start_handle = attr->handle + 1;
+            discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+            err = bt_gatt_discover(conn, &discover_params);
+            if (err) {
+                LOG_DBG("[Discover failed] (err %d)", err);
+            }
+        }
+
         return BT_GATT_ITER_STOP;
     }
 
@@ -289,6 +339,7 @@ static void discover_conn(struct bt_conn *conn) {
     int err;
 
     LOG_DBG("[Discovery started for conn]");
+    subscribe_index = 0;
     memcpy(&uuid, BT_UUID_HIDS, sizeof(uuid));
     discover_params.uuid = &uuid.uuid;
     discover_params.func = discover_func;
@@ -391,10 +442,19 @@ static void disconnected(struct bt_conn *conn, uint8_t reason) {
     }
 }
 
+static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
+                             uint16_t timeout) {
+    if (log_conn_param_updates) {
+        LOG_DBG("[Connection parameters updated]: interval %u latency %u timeout %u", interval,
+                latency, timeout);
+    }
+}
+
 BT_CONN_CB_DEFINE(conn_callbacks) = {
     .connected = connected,
     .disconnected = disconnected,
     .security_changed = security_changed,
+    .le_param_updated = le_param_updated,
 };
 
 struct bt_conn_auth_info_cb auth_info_cb = {
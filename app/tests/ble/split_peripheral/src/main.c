@@ -0,0 +1,290 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Minimal stand-in for a ZMK split peripheral. Once the central subscribes to position events,
+ * it sends a burst of presses for every position in a single notification, followed by a burst
+ * of releases, to exercise how the central copes with events arriving faster than it can
+ * process them.
+ *
+ * With CONFIG_ZMK_TEST_SPLIT_PERIPHERAL_RECONNECT, it instead taps one key, disconnects, and
+ * taps another key as soon as the central has subscribed again after reconnecting, logging how
+ * long that took.
+ *
+ * With CONFIG_ZMK_TEST_SPLIT_PERIPHERAL_INVOKE_BEHAVIOR, it also exposes the invoke behavior
+ * characteristic, reporting CONFIG_ZMK_TEST_SPLIT_PERIPHERAL_BEHAVIOR_TABLE_HASH as its behavior
+ * table hash. Behaviors invoked by the central are logged, by ID or by name.
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <errno.h>
+#include <zephyr/kernel.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(ble_split_peripheral, 4);
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <zmk/split/bluetooth/uuid.h>
+
+#define POSITION_COUNT 3
+#define POSITION_EVENT_PRESSED BIT(15)
+
+struct position_event {
+    uint16_t position;
+    uint16_t state_age;
+} __packed;
+
+struct position_events {
+    uint8_t sequence;
+    uint32_t timestamp;
+    struct position_event events[POSITION_COUNT];
+} __packed;
+
+// Mirrors zmk_split_run_behavior_payload.
+struct run_behavior_payload {
+    uint8_t position;
+    uint8_t state;
+    uint32_t param1;
+    uint32_t param2;
+    char behavior_dev[9];
+} __packed;
+
+// Mirrors zmk_split_invoke_behavior_data.
+struct invoke_behavior_data {
+    uint16_t behavior_id;
+    uint16_t position;
+    uint8_t state;
+    uint32_t param1;
+    uint32_t param2;
+} __packed;
+
+static uint8_t position_state;
+static uint8_t sequence;
+static bool send_presses = true;
+static int64_t connected_at;
+static uint8_t connection_count;
+
+static ssize_t read_position_state(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                   void *buf, uint16_t len, uint16_t offset) {
+    LOG_DBG("[Position state read]");
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &position_state,
+                             sizeof(position_state));
+}
+
+static ssize_t write_run_behavior(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                  const void *buf, uint16_t len, uint16_t offset, uint8_t flags) {
+    const struct run_behavior_payload *payload = buf;
+
+    if (len == sizeof(*payload)) {
+        LOG_DBG("[Invoke behavior by name] %.*s position %u state %u",
+                (int)sizeof(payload->behavior_dev), payload->behavior_dev, payload->position,
+                payload->state);
+    }
+
+    return len;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_TEST_SPLIT_PERIPHERAL_INVOKE_BEHAVIOR)
+
+static ssize_t read_behavior_table_hash(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                        void *buf, uint16_t len, uint16_t offset) {
+    uint32_t hash = sys_cpu_to_le32(CONFIG_ZMK_TEST_SPLIT_PERIPHERAL_BEHAVIOR_TABLE_HASH);
+
+    LOG_DBG("[Behavior table hash read]");
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &hash, sizeof(hash));
+}
+
+static ssize_t write_invoke_behavior(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                     const void *buf, uint16_t len, uint16_t offset,
+                                     uint8_t flags) {
+    const struct invoke_behavior_data *data = buf;
+
+    if (len == sizeof(*data)) {
+        LOG_DBG("[Invoke behavior by ID] behavior %u position %u state %u",
+                sys_le16_to_cpu(data->behavior_id), sys_le16_to_cpu(data->position),
+                data->state);
+    }
+
+    return len;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_TEST_SPLIT_PERIPHERAL_INVOKE_BEHAVIOR)
+
+static void position_state_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value) {
+    LOG_DBG("[Position state CCC changed] %d", value);
+}
+
+static void send_burst(struct k_work *work);
+static void send_tap(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(burst_work, send_burst);
+static K_WORK_DELAYABLE_DEFINE(tap_work, send_tap);
+
+static void position_events_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value) {
+    LOG_DBG("[Position events CCC changed] %d", value);
+
+    if (value != BT_GATT_CCC_NOTIFY) {
+        return;
+    }
+
+    if (!IS_ENABLED(CONFIG_ZMK_TEST_SPLIT_PERIPHERAL_RECONNECT)) {
+        k_work_reschedule(&burst_work, K_MSEC(500));
+    } else if (connection_count == 1) {
+        k_work_reschedule(&tap_work, K_MSEC(500));
+    } else {
+        LOG_DBG("[First key %d ms after reconnecting]", (int)(k_uptime_get() - connected_at));
+        k_work_reschedule(&tap_work, K_NO_WAIT);
+    }
+}
+
+BT_GATT_SERVICE_DEFINE(
+    split_svc, BT_GATT_PRIMARY_SERVICE(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_SERVICE_UUID)),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_STATE_UUID),
+                           BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_READ,
+                           read_position_state, NULL, NULL),
+    BT_GATT_CCC(position_state_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_EVENTS_UUID),
+                           BT_GATT_CHRC_NOTIFY, BT_GATT_PERM_NONE, NULL, NULL, NULL),
+    BT_GATT_CCC(position_events_ccc_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_RUN_BEHAVIOR_UUID),
+                           BT_GATT_CHRC_WRITE_WITHOUT_RESP, BT_GATT_PERM_WRITE, NULL,
+                           write_run_behavior, NULL)
+        IF_ENABLED(CONFIG_ZMK_TEST_SPLIT_PERIPHERAL_INVOKE_BEHAVIOR,
+                   (, BT_GATT_CHARACTERISTIC(
+                          BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_INVOKE_BEHAVIOR_UUID),
+                          BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                          BT_GATT_PERM_READ | BT_GATT_PERM_WRITE, read_behavior_table_hash,
+                          write_invoke_behavior, NULL))));
+
+static void send_burst(struct k_work *work) {
+    struct position_events payload = {.sequence = sequence,
+                                      .timestamp = sys_cpu_to_le32(k_uptime_get_32())};
+
+    for (int i = 0; i < POSITION_COUNT; i++) {
+        payload.events[i].position = sys_cpu_to_le16(i);
+        payload.events[i].state_age = sys_cpu_to_le16(send_presses ? POSITION_EVENT_PRESSED : 0);
+    }
+
+    position_state = send_presses ? BIT_MASK(POSITION_COUNT) : 0;
+    sequence += POSITION_COUNT;
+
+    LOG_DBG("[Sending %s burst]", send_presses ? "press" : "release");
+
+    int err = bt_gatt_notify(NULL, &split_svc.attrs[5], &payload, sizeof(payload));
+    if (err) {
+        LOG_DBG("[Notify failed] (err %d)", err);
+    }
+
+    if (send_presses) {
+        send_presses = false;
+        k_work_reschedule(&burst_work, K_MSEC(500));
+    }
+}
+
+static void send_position_event(uint16_t position, bool pressed) {
+    struct position_events payload = {.sequence = sequence,
+                                      .timestamp = sys_cpu_to_le32(k_uptime_get_32())};
+
+    payload.events[0].position = sys_cpu_to_le16(position);
+    payload.events[0].state_age = sys_cpu_to_le16(pressed ? POSITION_EVENT_PRESSED : 0);
+
+    WRITE_BIT(position_state, position, pressed);
+    sequence++;
+
+    int err = bt_gatt_notify(NULL, &split_svc.attrs[5], &payload,
+                             offsetof(struct position_events, events[1]));
+    if (err) {
+        LOG_DBG("[Notify failed] (err %d)", err);
+    }
+}
+
+static void disconnect_conn(struct bt_conn *conn, void *data) {
+    bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+}
+
+static void disconnect(struct k_work *work) {
+    LOG_DBG("[Disconnecting]");
+    bt_conn_foreach(BT_CONN_TYPE_LE, disconnect_conn, NULL);
+}
+
+static K_WORK_DELAYABLE_DEFINE(disconnect_work, disconnect);
+
+// Taps position 0 on the first connection and position 1 on the next, disconnecting in between.
+static void send_tap(struct k_work *work) {
+    uint16_t position = connection_count == 1 ? 0 : 1;
+
+    LOG_DBG("[Tapping position %d]", position);
+
+    send_position_event(position, true);
+    send_position_event(position, false);
+
+    if (connection_count == 1) {
+        k_work_reschedule(&disconnect_work, K_MSEC(500));
+    }
+}
+
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA_BYTES(BT_DATA_UUID128_ALL, ZMK_SPLIT_BT_SERVICE_UUID),
+};
+
+static void connected(struct bt_conn *conn, uint8_t conn_err) {
+    char addr[BT_ADDR_LE_STR_LEN];
+
+    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
+
+    if (conn_err) {
+        LOG_DBG("[Failed to connect to %s] (%u)", addr, conn_err);
+        return;
+    }
+
+    LOG_DBG("[Connected]: %s", addr);
+
+    connected_at = k_uptime_get();
+    connection_count++;
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason) {
+    char addr[BT_ADDR_LE_STR_LEN];
+
+    bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
+
+    LOG_DBG("[Disconnected]: %s (reason 0x%02x)", addr, reason);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+};
+
+void main(void) {
+    int err = bt_enable(NULL);
+
+    if (err) {
+        LOG_DBG("[Bluetooth init failed] (err %d)", err);
+        return;
+    }
+
+    LOG_DBG("[Bluetooth initialized]");
+
+    err = bt_le_adv_start(BT_LE_ADV_CONN, ad, ARRAY_SIZE(ad), NULL, 0);
+    if (err) {
+        LOG_DBG("[Advertising failed to start] (err %d)", err);
+        return;
+    }
+
+    LOG_DBG("[Advertising successfully started]");
+}